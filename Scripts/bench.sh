@@ -0,0 +1,110 @@
+#!/bin/bash
+# use: bench.sh [-baseline]
+#
+# Generates a fixed, seeded set of instances with makewff and makequeens,
+# runs walksat on each with a fixed seed and writes bench/report.csv:
+#   instance,flips_per_sec,seconds,seconds_to_solution,mean_flips_to_solution,success_rate,peak_rss_mb
+# seconds is the wall time of the whole run, seconds_to_solution the
+# solver's mean seconds until a solution.  seconds_to_solution and
+# mean_flips_to_solution are empty when no try succeeded, flips_per_sec
+# when the run was too short to time.
+#
+# Without -baseline the report is compared with bench/baseline.csv, which
+# is kept in the repository, and the script fails if the baseline is
+# missing or flips/sec dropped by more than BENCH_TOLERANCE percent
+# (default 10) on any instance that ran for at least a second.  A change
+# of mean_flips_to_solution means the search itself changed.  With
+# -baseline the report becomes the new baseline, to be committed with the
+# change that moved it; the stored one was taken on a single core VM, so
+# on other machines take a local baseline first.  Extra solver options can
+# be passed in BENCH_FLAGS.
+#
+# Run from the directory holding walksat, makewff and makequeens (make bench).
+
+mode=$1
+dir=bench
+tolerance=${BENCH_TOLERANCE:-10}
+seed=1
+
+mkdir -p $dir/instances
+
+# name generator-command tries cutoff numsol
+# Every instance is satisfiable and the runs stop after numsol solutions,
+# chosen so that each takes one to a few seconds.
+instances=(
+    "f3-v200-r420   ./makewff -seed 12 -cnf 3 200 840        2000  1000000   200"
+    "f3-v600-r420   ./makewff -seed 31 -cnf 3 600 2520       200   2000000   10"
+    "f3-v2000-r415  ./makewff -seed 14 -cnf 3 2000 8300      100   10000000  5"
+    "f3-v20000-r410 ./makewff -seed 15 -cnf 3 20000 82000    10    50000000  3"
+    "f5-v200-r1800  ./makewff -seed 21 -cnf 5 200 3600       200   1000000   20"
+    "f5-v500-r1700  ./makewff -seed 22 -cnf 5 500 8500       100   10000000  3"
+    "q16            ./makequeens 16                          10000 100000    4000"
+    "q32            ./makequeens 32                          4000  1000000   800"
+    "q64            ./makequeens 64                          400   1000000   100"
+)
+
+report=$dir/report.csv
+echo "instance,flips_per_sec,seconds,seconds_to_solution,mean_flips_to_solution,success_rate,peak_rss_mb" > $report
+
+for line in "${instances[@]}"
+do
+    set -- $line
+    name=$1
+    shift
+    numsol=${@: -1}
+    cutoff=${@: -2:1}
+    tries=${@: -3:1}
+    gen=("${@:1:$#-3}")
+
+    cnf=$dir/instances/$name.cnf
+    if [ ! -s $cnf ]; then
+        "${gen[@]}" > $cnf 2> /dev/null || exit 1
+    fi
+
+    ./walksat -seed $seed -tries $tries -cutoff $cutoff -numsol $numsol $BENCH_FLAGS $cnf > $dir/$name.out || exit 1
+    awk -v name=$name '
+        /^total elapsed seconds =/          { seconds = $NF }
+        /^average flips per second =/       { fps = $NF }
+        /^final success rate =/             { rate = $NF }
+        /^mean flips until assign =/        { mean = $NF }
+        /^mean seconds until assign =/      { tts = $NF }
+        /^  peak resident set:/             { rss = $(NF-1) }
+        END {
+            # a run too short to time has no rate
+            fps = seconds > 0 ? sprintf("%.0f", fps) : ""
+            printf "%s,%s,%.3f,%s,%s,%s,%s\n", name, fps, seconds, tts, mean, rate, rss
+        }
+    ' $dir/$name.out >> $report
+    tail -n 1 $report
+done
+
+if [ "$mode" == "-baseline" ]; then
+    cp $report $dir/baseline.csv
+    echo "baseline written to $dir/baseline.csv"
+    exit 0
+fi
+
+if [ ! -f $dir/baseline.csv ]; then
+    echo "no baseline in $dir/baseline.csv, run make bench-baseline first"
+    exit 1
+fi
+
+awk -F, -v tol=$tolerance '
+    FNR == 1 { next }
+    NR == FNR { fps[$1] = $2; secs[$1] = $3; flips[$1] = $5; next }
+    !($1 in fps) { printf "%-16s not in baseline\n", $1; next }
+    {
+        note = flips[$1] != $5 ? "  search changed" : ""
+        if (secs[$1] < 1 || $3 < 1 || fps[$1] == "" || $2 == "") {
+            printf "%-16s too short to compare flips/sec%s\n", $1, note
+            next
+        }
+        change = 100.0 * ($2 - fps[$1]) / fps[$1]
+        if (change < -tol) {
+            note = "  REGRESSION" note
+            bad++
+        }
+        printf "%-16s %12.0f -> %12.0f flips/sec %+7.1f%%%s\n", $1, fps[$1], $2, change, note
+    }
+    END { exit bad > 0 }
+' $dir/baseline.csv $report
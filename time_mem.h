@@ -24,6 +24,7 @@ THE SOFTWARE.
 #ifndef TIME_MEM_H
 #define TIME_MEM_H
 #include <cassert>
+#include <cstdint>
 #include <time.h>
 
 #include <ios>
@@ -44,6 +45,12 @@ static inline double cpuTimeTotal(void)
     return (double)clock() / CLOCKS_PER_SEC;
 }
 
+// high-water mark of the resident set in bytes, 0 if unknown
+static inline uint64_t memUsedPeak(void)
+{
+    return 0;
+}
+
 #else //Linux or POSIX
 #include <sys/time.h>
 #include <sys/resource.h>
@@ -71,6 +78,19 @@ static inline double cpuTimeTotal(void)
     return (double)ru.ru_utime.tv_sec + ((double)ru.ru_utime.tv_usec / 1000000.0);
 }
 
+// high-water mark of the resident set in bytes, 0 if unknown
+static inline uint64_t memUsedPeak(void)
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+    #ifdef __APPLE__
+    return (uint64_t)ru.ru_maxrss;  // bytes on macOS
+    #else
+    return (uint64_t)ru.ru_maxrss * 1024;  // KB elsewhere
+    #endif
+}
+
 #endif
 
 #if defined(__linux__)
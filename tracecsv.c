@@ -0,0 +1,81 @@
+/************************************/
+/* tracecsv: flip trace to CSV      */
+/************************************/
+
+/* use: tracecsv trace-file > trace.csv                               */
+/*                                                                    */
+/* Reads a trace written by walksat -trace and prints one line per    */
+/* flip:  try,flip,var,numfalse                                       */
+/* Each try also gets a line with flip 0, var 0 and its starting      */
+/* numfalse (flip is the resumed flip for a try continued from a      */
+/* checkpoint).  With -restart current or best the flips of the       */
+/* restart come just before it, as lines with flip 0 and the var      */
+/* flipped.  The record layout is described in walksat_trace.cpp.     */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TRACE_TRY 0xffffffffu
+#define TRACE_RESTART 0xfffffffeu
+#define TRACE_VERSION 2
+
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numvars;
+    uint32_t numclauses;
+    uint32_t seed;
+};
+
+int main(int argc, char** argv)
+{
+    FILE* in;
+    struct TraceHeader h;
+    uint32_t rec[2];
+    uint32_t tryno = 0;
+    int64_t flip = 0;
+    int restarting = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "use: %s trace-file\n", argv[0]);
+        return 1;
+    }
+    in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    if (fread(&h, sizeof(h), 1, in) != 1 || memcmp(h.magic, "\x7fWSTRACE", 8) != 0
+        || h.version != TRACE_VERSION) {
+        fprintf(stderr, "%s is not a walksat trace\n", argv[1]);
+        return 1;
+    }
+
+    printf("try,flip,var,numfalse\n");
+    while (fread(rec, sizeof(rec), 1, in) == 1) {
+        if (rec[0] == TRACE_RESTART) {
+            /* the flips up to the next try header belong to that try */
+            tryno = rec[1];
+            flip = 0;
+            restarting = 1;
+            continue;
+        }
+        if (rec[0] == TRACE_TRY) {
+            restarting = 0;
+            uint32_t at[2], start[2];
+            if (fread(at, sizeof(at), 1, in) != 1 || fread(start, sizeof(start), 1, in) != 1)
+                break;
+            tryno = rec[1];
+            flip = (int64_t)(((uint64_t)at[1] << 32) | at[0]);
+            printf("%u,%lld,0,%u\n", tryno, (long long)flip, start[0]);
+            continue;
+        }
+        if (!restarting)
+            flip++;
+        printf("%u,%lld,%u,%u\n", tryno, (long long)flip, rec[0] + 1, rec[1]);
+    }
+    fclose(in);
+    return 0;
+}
@@ -21,124 +21,484 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 ***********************************************/
 
-/********************************************************************/
-/* Following tests set exactly one of the following flags to 1:     */
-/*    BSD:   BSD Unix                                               */
-/*    OSX:   Apple OS X                                           */
-/*    LINUX: Linux Unix                                           */
-/*    WINDOWS: Windows and DOS. Linking requires -l Winmm.lib       */
-/*    POSIX: Other POSIX OS                                         */
-/* Platform dependent differences:                                  */
-/*    WINDOWS and POSIX use rand() instead of random()              */
-/*    Clock ticks per second determined by sysconf(_SC_CLK_TCK)     */
-/*        for BSD, OSX, and LINUX                                   */
-/*    Clock ticks per second fixed at 1000 for Windows              */
-/*    Clock ticks per second fixed at 1 for POSIX                   */
-/********************************************************************/
-
-#include "time_mem.h"
-
-#if __FreeBSD__ || __NetBSD__ || __OpenBSD__ || __bsdi__ || _SYSTYPE_BSD
-#define BSD 1
-#elif __APPLE__ && __MACH__
-#define OSX 1
-#elif __unix__ || __unix || unix || __gnu_linux__ || linux || __linux
-#define LINUX 1
-#elif _WIN64 || _WIN23 || _WIN16 || __MSDOS__ || MSDOS || _MSDOS || __DOS__
-#define NT 1
-#else
-#define POSIX 1
-#endif
-
-//printing
-#if BSD || OSX || LINUX
-#define BIGFORMAT "li"
-#elif WINDOWS
-#define BIGFORMAT "I64d"
-#endif
-
 /************************************/
 /* Standard includes                */
 /************************************/
 
+#include <algorithm>
 #include <limits>
 #include <cstdio>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include "walksat.h"
+#include "walksat_internal.h"
 
-#ifdef WINDOWS
-#define random() rand()
-#define srandom(seed) srand(seed)
+#ifdef WALKSAT_X86_KERNELS
+#include <immintrin.h>
 #endif
 
 /************************************/
 /* Constant parameters              */
 /************************************/
 
-#define BIG 1000000000     /* a number bigger that the possible number of violated clauses */
-#define MAXATTEMPT 10      /* max number of times to attempt to find a non-tabu variable to flip */
-#define denominator 100000 /* denominator used in fractions to represent probabilities */
-#define ONE_PERCENT 1000   /* ONE_PERCENT / denominator = 0.01 */
+#define SIMD_MIN_CLAUSE 8  /* shortest clause handed to the vector kernels */
+#define SIMD_PAD 3         /* extra bytes after assigns[] so 32-bit gathers stay in bounds */
+#define PIPE_CHUNK 64      /* occurrences per pass in flipvar_pipelined() */
+#define PREFETCH_DIST 16   /* how many occurrences ahead flipvar_pipelined() prefetches */
+
+/* Binary formula file, see write_binary(); in native byte order, followed */
+/* by clsize[numclauses] and the literals of all clauses as Lit words      */
+#define BINARY_VERSION 1
+static const char BINARY_MAGIC[8] = {'\x7f', 'W', 'A', 'L', 'K', 'S', 'A', 'T'};
+struct BinaryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numvars;
+    uint32_t numclauses;
+    uint32_t numliterals;
+};
 
 using namespace CMSat;
 
 /* #define DEBUG */
 
 /**************************************/
-/* Inline utility functions           */
+/* Vector kernels for long clauses    */
 /**************************************/
 
-static inline int ABS(int x)
+/* Lit is a single uint32_t (var*2 + sign), so a clause can be loaded   */
+/* directly as a vector of 32-bit lanes.  The tie list is written in    */
+/* clause order, exactly like the scalar loop, so the random choices    */
+/* made afterwards (and hence the whole search) do not depend on which  */
+/* kernel was used.  Each function carries its own target attribute so */
+/* that all of them are compiled into one binary, see detect_kernel().  */
+
+#ifdef WALKSAT_X86_KERNELS
+/* lanes of the chunk starting at i that lie inside the clause */
+KERNEL_AVX512_TARGET
+static inline __mmask16 chunk_mask16(uint32_t i, uint32_t size)
+{
+    return size - i >= 16 ? (__mmask16)0xffff : (__mmask16)((1U << (size - i)) - 1);
+}
+
+KERNEL_AVX512_TARGET
+static inline uint32_t min_break_avx512(const Lit* lits, uint32_t size,
+                                        const uint32_t* breakcount, int* best,
+                                        uint32_t* numbest)
+{
+    const __m512i none = _mm512_set1_epi32(-1);
+    __m512i vmin = none;
+    for (uint32_t i = 0; i < size; i += 16) {
+        const __mmask16 in = chunk_mask16(i, size);
+        __m512i vars = _mm512_srli_epi32(_mm512_maskz_loadu_epi32(in, lits + i), 1);
+        vmin = _mm512_min_epu32(vmin, _mm512_mask_i32gather_epi32(none, in, vars, breakcount, 4));
+    }
+    const uint32_t bestvalue = _mm512_reduce_min_epu32(vmin);
+
+    uint32_t n = 0;
+    const __m512i vbest = _mm512_set1_epi32(bestvalue);
+    for (uint32_t i = 0; i < size; i += 16) {
+        const __mmask16 in = chunk_mask16(i, size);
+        __m512i vars = _mm512_srli_epi32(_mm512_maskz_loadu_epi32(in, lits + i), 1);
+        __m512i bc = _mm512_mask_i32gather_epi32(none, in, vars, breakcount, 4);
+        __mmask16 tie = _mm512_mask_cmpeq_epi32_mask(in, bc, vbest);
+        _mm512_mask_compressstoreu_epi32(best + n, tie, vars);
+        n += __builtin_popcount(tie);
+    }
+    *numbest = n;
+    return bestvalue;
+}
+
+/* mask of the true literals in the chunk starting at i */
+KERNEL_AVX512_TARGET
+static inline __mmask16 true_lits_avx512(const Lit* lits, uint32_t i, uint32_t size,
+                                         const lbool* assigns)
 {
-    return x < 0 ? -x : x;
+    const __m512i lowbyte = _mm512_set1_epi32(0xff);
+    const __mmask16 in = chunk_mask16(i, size);
+    __m512i l = _mm512_maskz_loadu_epi32(in, lits + i);
+    /* byte-granular 32-bit gather, the low byte is the lbool of the var */
+    __m512i vals = _mm512_and_si512(
+        _mm512_mask_i32gather_epi32(lowbyte, in, _mm512_srli_epi32(l, 1), assigns, 1), lowbyte);
+    /* l_True is 0, so a literal is true when its var's value equals its sign */
+    return _mm512_mask_cmpeq_epi32_mask(in, vals, _mm512_and_si512(l, _mm512_set1_epi32(1)));
 }
 
-static inline int RANDMOD(int x)
+KERNEL_AVX512_TARGET
+static inline bool clause_sat_avx512(const Lit* lits, uint32_t size, const lbool* assigns)
 {
-    return x > 1 ? random() % x : 0;
+    for (uint32_t i = 0; i < size; i += 16) {
+        if (true_lits_avx512(lits, i, size, assigns))
+            return true;
+    }
+    return false;
 }
 
-static inline int MAX(int x, int y)
+/* number of true literals, *truelit is set to one of them */
+KERNEL_AVX512_TARGET
+static inline uint32_t count_true_avx512(const Lit* lits, uint32_t size, const lbool* assigns,
+                                         Lit* truelit)
 {
-    return x > y ? x : y;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < size; i += 16) {
+        const uint32_t mask = true_lits_avx512(lits, i, size, assigns);
+        if (mask) {
+            *truelit = lits[i + __builtin_ctz(mask)];
+            n += __builtin_popcount(mask);
+        }
+    }
+    return n;
 }
 
+/* lanes of the chunk starting at i that lie inside the clause */
+KERNEL_AVX2_TARGET
+static inline __m256i chunk_mask8(uint32_t i, uint32_t size)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(size - i)), lane);
+}
+
+KERNEL_AVX2_TARGET
+static inline uint32_t hmin_epu32(__m256i v)
+{
+    __m128i m = _mm_min_epu32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(m);
+}
+
+KERNEL_AVX2_TARGET
+static inline uint32_t min_break_avx2(const Lit* lits, uint32_t size,
+                                      const uint32_t* breakcount, int* best,
+                                      uint32_t* numbest)
+{
+    const int* base = (const int*)breakcount;
+    const __m256i none = _mm256_set1_epi32(-1);
+    __m256i vmin = none;
+    for (uint32_t i = 0; i < size; i += 8) {
+        const __m256i in = chunk_mask8(i, size);
+        __m256i vars = _mm256_srli_epi32(_mm256_maskload_epi32((const int*)(lits + i), in), 1);
+        vmin = _mm256_min_epu32(vmin, _mm256_mask_i32gather_epi32(none, base, vars, in, 4));
+    }
+    const uint32_t bestvalue = hmin_epu32(vmin);
+
+    uint32_t n = 0;
+    const __m256i vbest = _mm256_set1_epi32(bestvalue);
+    for (uint32_t i = 0; i < size; i += 8) {
+        const __m256i in = chunk_mask8(i, size);
+        __m256i vars = _mm256_srli_epi32(_mm256_maskload_epi32((const int*)(lits + i), in), 1);
+        __m256i bc = _mm256_mask_i32gather_epi32(none, base, vars, in, 4);
+        __m256i tie = _mm256_and_si256(_mm256_cmpeq_epi32(bc, vbest), in);
+        uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(tie));
+        while (mask) {
+            best[n++] = lits[i + __builtin_ctz(mask)].var();
+            mask &= mask - 1;
+        }
+    }
+    *numbest = n;
+    return bestvalue;
+}
+
+/* mask of the true literals in the chunk starting at i, one bit per lane */
+KERNEL_AVX2_TARGET
+static inline uint32_t true_lits_avx2(const Lit* lits, uint32_t i, uint32_t size,
+                                      const lbool* assigns)
+{
+    const __m256i lowbyte = _mm256_set1_epi32(0xff);
+    const __m256i in = chunk_mask8(i, size);
+    __m256i l = _mm256_maskload_epi32((const int*)(lits + i), in);
+    /* byte-granular 32-bit gather, the low byte is the lbool of the var */
+    __m256i vals = _mm256_and_si256(
+        _mm256_mask_i32gather_epi32(lowbyte, (const int*)assigns, _mm256_srli_epi32(l, 1), in, 1),
+        lowbyte);
+    /* l_True is 0, so a literal is true when its var's value equals its sign */
+    __m256i eq = _mm256_cmpeq_epi32(vals, _mm256_and_si256(l, _mm256_set1_epi32(1)));
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(eq, in)));
+}
+
+KERNEL_AVX2_TARGET
+static inline bool clause_sat_avx2(const Lit* lits, uint32_t size, const lbool* assigns)
+{
+    for (uint32_t i = 0; i < size; i += 8) {
+        if (true_lits_avx2(lits, i, size, assigns))
+            return true;
+    }
+    return false;
+}
+
+/* number of true literals, *truelit is set to one of them */
+KERNEL_AVX2_TARGET
+static inline uint32_t count_true_avx2(const Lit* lits, uint32_t size, const lbool* assigns,
+                                       Lit* truelit)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < size; i += 8) {
+        const uint32_t mask = true_lits_avx2(lits, i, size, assigns);
+        if (mask) {
+            *truelit = lits[i + __builtin_ctz(mask)];
+            n += __builtin_popcount(mask);
+        }
+    }
+    return n;
+}
+#endif //WALKSAT_X86_KERNELS
+
 /************************************/
 /* Main                             */
 /************************************/
 
-int WalkSAT::main()
+/* SIGTERM, SIGINT and SIGXCPU end the search at the next poll(); a  */
+/* second one is not caught, so it kills a search that does not poll */
+volatile sig_atomic_t stop_signal = 0;
+
+static void on_stop_signal(int sig)
+{
+    stop_signal = sig;
+    signal(sig, SIG_DFL);
+}
+
+void WalkSAT::install_stop_handlers()
+{
+    signal(SIGTERM, on_stop_signal);
+    signal(SIGINT, on_stop_signal);
+#ifdef SIGXCPU
+    signal(SIGXCPU, on_stop_signal);
+#endif
+}
+
+int WalkSAT::main(int argc, char** argv)
 {
     seed = 0;
-    parse_parameters();
-    srandom(seed);
+    parse_parameters(argc, argv);
+    rng.seed(seed, worker_id);
     print_parameters();
-    initprob();
+    numa_setup();
+    if (batch_path != NULL)
+        return batch_main();
+    if (daemon_path != NULL)
+        return daemon_main();
+    if (!initprob())
+        exit(-1);
+    if (binary_path != NULL) {
+        if (!write_binary(binary_path))
+            exit(-1);
+        printf("binary formula written to %s\n", binary_path);
+        return 0;
+    }
+    numa_place_formula();
+    alloc_walker();
+    sample_memory();
+    install_stop_handlers();
+    deadline = time_limit > 0 ? wallTime() + time_limit : 0;
+    if (tune)
+        tune_parameters();
+    models_open();
+    model_output_open();
+    trace_open();
+    perf_open();
+    stats_open();
     initialize_statistics();
     print_statistics_header();
+    if (resume_path != NULL)
+        checkpoint_read();
+    checkpoint_setup();
+
+    if (colorflip)
+        colorflip_start();
+    /* the cooperative engine replaces the try loop */
+    if (coop_requested)
+        coop_main();
+    else
+        run_tries();
+    if (colorflip)
+        colorflip_stop();
+    if (stopped)
+        printf("search stopped by %s\n", stop_reason);
+    trace_close();
+    /* with several workers, count the CPU time of all of them */
+    expertime = (coop || colorflip ? cpuTimeTotal() : cpuTime()) + resumed_seconds;
+    print_statistics_final();
+    models_close();
+    model_output_close();
+    return found_solution;
+}
 
-    while (!found_solution && numtry < numrun) {
-        numtry++;
-        init();
-        update_statistics_start_try();
-        numflip = 0;
-
-        while ((numfalse > 0) && (numflip < cutoff)) {
-            numflip++;
-
-            uint32_t var = pickbest();
-            flipvar(var);
-            update_statistics_end_flip();
+/* Tries until numsol solutions are found or the tries run out */
+void WalkSAT::run_tries()
+{
+    stopped = false;
+    try_deadline = 0;
+    budget_exhausted();
+    while (resuming || ((models != NULL ? models_found : found_solution) < numsol
+                        && numtry < numrun && !stopped)) {
+        if (resuming) {
+            /* the try of the checkpoint, state restored by checkpoint_read() */
+            resuming = false;
+            try_start = wallTime();
+            try_deadline = try_time_limit > 0 ? try_start + try_time_limit : 0;
+            perf_try_start();
+            stats_try_start();
+            if (trace != NULL)
+                trace_try_start();
+        } else {
+            numtry++;
+            init();
+            numflip = 0;
+            update_statistics_start_try();
         }
+        if (colorflip)
+            colorflip_loop();
+        else
+            flip_loop();
         update_and_print_statistics_end_try();
     }
-    expertime = cpuTime();
-    print_statistics_final();
-    return found_solution;
+    /* the last try may have failed after an earlier one succeeded */
+    if (found_solution && numfalse != 0 && solution != NULL) {
+        memcpy(assigns, solution, sizeof(lbool) * numvars);
+        numfalse = countunsat();
+    }
+}
+
+/* One try: flip until satisfied or cutoff.  pickbest(), the flip and the */
+/* statistics are inlined into each per instruction set copy below.       */
+template<int K, class Stats, class Flip, class Trace>
+inline void WalkSAT::flip_loop_k()
+{
+    while ((numfalse > 0) && (numflip < cutoff)) {
+        numflip++;
+
+        uint32_t var = pickbest<K>();
+        Flip::flip(*this, var);
+        Stats::end_flip(*this, var);
+        Trace::record(*this, var);
+        if (numflip >= next_poll && poll())
+            break;
+    }
+}
+
+/* Picks the flip loop for the options, once per try */
+template<int K, class Trace, class Work>
+inline void WalkSAT::flip_loop_stats()
+{
+    if (lean) {
+        if (prefetch)
+            flip_loop_k<K, LeanStats, PipelinedFlip<Work>, Trace>();
+        else
+            flip_loop_k<K, LeanStats, PlainFlip<Work>, Trace>();
+    } else {
+        if (prefetch)
+            flip_loop_k<K, FullStats, PipelinedFlip<Work>, Trace>();
+        else
+            flip_loop_k<K, FullStats, PlainFlip<Work>, Trace>();
+    }
+}
+
+/* Only the loops of -perf count the work of flipvar() */
+template<int K, class Trace>
+inline void WalkSAT::flip_loop_work()
+{
+    if (perfstate != NULL)
+        flip_loop_stats<K, Trace, CountWork>();
+    else
+        flip_loop_stats<K, Trace, NoWork>();
+}
+
+template<int K>
+inline void WalkSAT::flip_loop_policy()
+{
+#ifndef WALKSAT_NO_TRACE
+    if (trace != NULL) {
+        flip_loop_work<K, TraceFlips>();
+        return;
+    }
+#endif
+    flip_loop_work<K, NoTrace>();
+}
+
+void WalkSAT::flip_loop_scalar()
+{
+    flip_loop_policy<KERNEL_SCALAR>();
+}
+
+KERNEL_AVX2_TARGET void WalkSAT::flip_loop_avx2()
+{
+    flip_loop_policy<KERNEL_AVX2>();
+}
+
+KERNEL_AVX512_TARGET void WalkSAT::flip_loop_avx512()
+{
+    flip_loop_policy<KERNEL_AVX512>();
+}
+
+void WalkSAT::flip_loop()
+{
+    switch (kernel) {
+        case KERNEL_AVX512:
+            flip_loop_avx512();
+            break;
+        case KERNEL_AVX2:
+            flip_loop_avx2();
+            break;
+        default:
+            flip_loop_scalar();
+            break;
+    }
+}
+
+/* Flips the given vars in order without statistics: to time flipvar() */
+/* alone, and to take back the flips of -colorflip past a solution     */
+void WalkSAT::replay_flips(const uint32_t* vars, uint32_t n)
+{
+    if (prefetch) {
+        for (uint32_t i = 0; i < n; i++)
+            flipvar_pipelined<NoWork>(vars[i]);
+    } else {
+        for (uint32_t i = 0; i < n; i++)
+            flipvar<NoWork>(vars[i]);
+    }
+}
+
+/* Called every POLL_INTERVAL flips from the flip loops, out of the fast */
+/* path.  Returns true if the try should be abandoned.                  */
+bool WalkSAT::poll()
+{
+    next_poll = numflip + POLL_INTERVAL;
+    if (!quiet)
+        flush_progress();
+    if (stats != NULL)
+        stats_progress();
+    if (checkpoint_path != NULL)
+        checkpoint_poll();
+    if (budget_exhausted())
+        return true;
+    return coop != NULL && coop_poll();
+}
+
+/* Stop signals and time limits, a clock read every POLL_INTERVAL flips */
+/* at most.  Returns true if the try should end; stopped is set if the  */
+/* whole search should.                                                 */
+bool WalkSAT::budget_exhausted()
+{
+    if (stop_signal != 0) {
+        stopped = true;
+        stop_reason = "signal";
+        return true;
+    }
+    if (deadline == 0 && try_deadline == 0)
+        return false;
+    const double now = wallTime();
+    if (deadline > 0 && now >= deadline) {
+        stopped = true;
+        stop_reason = "time limit";
+        return true;
+    }
+    return try_deadline > 0 && now >= try_deadline;
 }
 
-void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
+template<class Work>
+inline void WalkSAT::flipvar(uint32_t toflip)
 {
     uint32_t i;
     Lit toenforce;
@@ -154,10 +514,13 @@ void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
 
     assert(value(toflip) != l_Undef);
     assigns[toflip] = assigns[toflip] ^ true;
+    if (zobrist != NULL)
+        assign_hash ^= zobrist[toflip];
 
     //True made into False
     numocc = numoccurrence[(~toenforce).toInt()];
     occptr = occurrence[(~toenforce).toInt()];
+    Work::visited(*this, numocc);
     for (i = 0; i < numocc; i++) {
         /* cli = occurrence[(~toenforce).toInt()][i]; */
         cli = *(occptr++);
@@ -172,6 +535,7 @@ void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
             breakcount[toflip]--;
         } else if (numtruelit[cli] == 1) {
             /* Find the lit in this clause that makes it true, and inc its breakcount */
+            Work::rescan(*this);
             litptr = clause[cli];
             while (1) {
                 /* lit = clause[cli][j]; */
@@ -180,7 +544,7 @@ void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
                     breakcount[lit.var()]++;
 
                     /* Swap lit into first position in clause */
-                    if ((--litptr) != clause[cli]) {
+                    if ((--litptr) != clause[cli] && !shared_clauses) {
                         Lit temp = clause[cli][0];
                         clause[cli][0] = *(litptr);
                         *(litptr) = temp;
@@ -193,6 +557,7 @@ void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
 
     numocc = numoccurrence[toenforce.toInt()];
     occptr = occurrence[toenforce.toInt()];
+    Work::visited(*this, numocc);
     for (i = 0; i < numocc; i++) {
         /* cli = occurrence[numvars+toenforce][i]; */
         cli = *(occptr++);
@@ -207,6 +572,7 @@ void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
         } else if (numtruelit[cli] == 2) {
             /* Find the lit in this clause other than toflip that makes it true,
              * and decrement its breakcount */
+            Work::rescan(*this);
             litptr = clause[cli];
             while (1) {
                 /* lit = clause[cli][j]; */
@@ -221,32 +587,482 @@ void WalkSAT::WalkSAT::flipvar(uint32_t toflip)
     }
 }
 
+/* Same updates as flipvar(), restructured for memory-level parallelism on */
+/* formulas that do not fit in cache.  Each occurrence list is processed  */
+/* in chunks: the first pass only adjusts numtruelit[] (prefetching a few */
+/* entries ahead) and records the clauses that changed state; the second  */
+/* pass does the false list and breakcount fix-ups for those, prefetching */
+/* their literals ahead.  Fix-ups are applied in occurrence order, so the */
+/* resulting state is identical to flipvar().                             */
+template<class Work>
+inline void WalkSAT::flipvar_pipelined(uint32_t toflip)
+{
+    uint32_t pend[PIPE_CHUNK];
+    bool pend_edge[PIPE_CHUNK]; /* clause went to 0 (resp. 1) true literals */
+    Lit toenforce;
+
+    if (assigns[toflip] == l_True)
+        toenforce = Lit(toflip, true);
+    else
+        toenforce = Lit(toflip, false);
+
+    assert(value(toflip) != l_Undef);
+    assigns[toflip] = assigns[toflip] ^ true;
+    if (zobrist != NULL)
+        assign_hash ^= zobrist[toflip];
+
+    //True made into False
+    uint32_t numocc = numoccurrence[(~toenforce).toInt()];
+    const uint32_t* occptr = occurrence[(~toenforce).toInt()];
+    Work::visited(*this, numocc);
+    for (uint32_t start = 0; start < numocc; start += PIPE_CHUNK) {
+        const uint32_t end = std::min(numocc, start + PIPE_CHUNK);
+        uint32_t npend = 0;
+        for (uint32_t i = start; i < end; i++) {
+            if (i + PREFETCH_DIST < numocc)
+                __builtin_prefetch(&numtruelit[occptr[i + PREFETCH_DIST]], 1);
+            const uint32_t cli = occptr[i];
+            assert(numtruelit[cli] > 0);
+            const uint32_t ntrue = --numtruelit[cli];
+            if (ntrue <= 1) {
+                __builtin_prefetch(&clause[cli]);
+                pend_edge[npend] = ntrue == 0;
+                pend[npend++] = cli;
+            }
+        }
+
+        for (uint32_t k = 0; k < npend; k++) {
+            if (k + PREFETCH_DIST / 4 < npend && !pend_edge[k + PREFETCH_DIST / 4])
+                __builtin_prefetch(clause[pend[k + PREFETCH_DIST / 4]]);
+            const uint32_t cli = pend[k];
+            if (pend_edge[k]) {
+                false_cls[numfalse] = cli;
+                wherefalse[cli] = numfalse;
+                numfalse++;
+                breakcount[toflip]--;
+            } else {
+                /* Find the lit that makes it true, inc its breakcount, swap it first */
+                Work::rescan(*this);
+                Lit* litptr = clause[cli];
+                while (value(*litptr) != l_True)
+                    litptr++;
+                breakcount[litptr->var()]++;
+                if (litptr != clause[cli] && !shared_clauses) {
+                    Lit temp = clause[cli][0];
+                    clause[cli][0] = *litptr;
+                    *litptr = temp;
+                }
+            }
+        }
+    }
+
+    numocc = numoccurrence[toenforce.toInt()];
+    occptr = occurrence[toenforce.toInt()];
+    Work::visited(*this, numocc);
+    for (uint32_t start = 0; start < numocc; start += PIPE_CHUNK) {
+        const uint32_t end = std::min(numocc, start + PIPE_CHUNK);
+        uint32_t npend = 0;
+        for (uint32_t i = start; i < end; i++) {
+            if (i + PREFETCH_DIST < numocc)
+                __builtin_prefetch(&numtruelit[occptr[i + PREFETCH_DIST]], 1);
+            const uint32_t cli = occptr[i];
+            const uint32_t ntrue = ++numtruelit[cli];
+            if (ntrue <= 2) {
+                if (ntrue == 1)
+                    __builtin_prefetch(&wherefalse[cli]);
+                else
+                    __builtin_prefetch(&clause[cli]);
+                pend_edge[npend] = ntrue == 1;
+                pend[npend++] = cli;
+            }
+        }
+
+        for (uint32_t k = 0; k < npend; k++) {
+            if (k + PREFETCH_DIST / 4 < npend && !pend_edge[k + PREFETCH_DIST / 4])
+                __builtin_prefetch(clause[pend[k + PREFETCH_DIST / 4]]);
+            const uint32_t cli = pend[k];
+            if (pend_edge[k]) {
+                numfalse--;
+                false_cls[wherefalse[cli]] = false_cls[numfalse];
+                wherefalse[false_cls[numfalse]] = wherefalse[cli];
+                breakcount[toflip]++;
+            } else {
+                /* Find the other lit that makes it true and dec its breakcount */
+                Work::rescan(*this);
+                const Lit* litptr = clause[cli];
+                while (value(*litptr) != l_True || litptr->var() == toflip)
+                    litptr++;
+                assert(breakcount[litptr->var()] > 0);
+                breakcount[litptr->var()]--;
+            }
+        }
+    }
+}
+
+/************************************/
+/* Kernel selection                 */
+/************************************/
+
+KernelType WalkSAT::detect_kernel()
+{
+#ifdef WALKSAT_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return KERNEL_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return KERNEL_AVX2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+bool WalkSAT::kernel_supported(KernelType k)
+{
+    return k <= detect_kernel();
+}
+
+const char* WalkSAT::kernel_name(KernelType k)
+{
+    switch (k) {
+        case KERNEL_SCALAR:
+            return "scalar";
+        case KERNEL_AVX2:
+            return "avx2";
+        case KERNEL_AVX512:
+            return "avx512";
+        default:
+            return "auto";
+    }
+}
+
 /************************************/
 /* Initialization                   */
 /************************************/
 
-void WalkSAT::parse_parameters()
+void WalkSAT::print_usage(const char* prog)
+{
+    fprintf(stderr, "Usage: %s [options] [cnf-file]\n", prog);
+    fprintf(stderr, "Reads the formula from stdin if no file is given.\n");
+    fprintf(stderr, "  -seed N           random seed\n");
+    fprintf(stderr, "  -cutoff N         flips per try, K and M suffixes allowed\n");
+    fprintf(stderr, "  -tries N          number of tries\n");
+    fprintf(stderr, "  -numsol N         stop after N solutions (tries that succeed)\n");
+    fprintf(stderr, "  -trace FILE       record every flip in FILE, see tracecsv\n");
+    fprintf(stderr, "  -distinct         count distinct solutions only, print each when found\n");
+    fprintf(stderr, "  -mindist D        count solutions differing in at least D vars from the others\n");
+    fprintf(stderr, "  -modelformat F    write models as lines, packed or bitmap\n");
+    fprintf(stderr, "  -modelfile FILE   write models to FILE instead of stdout\n");
+    fprintf(stderr, "  -walkprob R       probability of a random walk step\n");
+    fprintf(stderr, "  -init I           starting assignment: random, polarity, greedy or unitprop\n");
+    fprintf(stderr, "  -initnoise R      fraction of vars set randomly by -init polarity and greedy\n");
+    fprintf(stderr, "  -restart M        tries after the first start from: full (-init), current or best\n");
+    fprintf(stderr, "  -perturb R        fraction of vars flipped by -restart current and best\n");
+    fprintf(stderr, "  -tune             choose -walkprob, -cutoff and -restart by probing first\n");
+    fprintf(stderr, "  -tuneflips N      flips per configuration in the first round of -tune\n");
+    fprintf(stderr, "  -kernel K         auto, scalar, avx2 or avx512\n");
+    fprintf(stderr, "  -prefetch         pipelined flips with prefetching, for huge formulas\n");
+    fprintf(stderr, "  -threads N        number of threads\n");
+    fprintf(stderr, "  -colorflip        flip vars sharing no clause in parallel, for huge formulas\n");
+    fprintf(stderr, "  -coop             cooperative workers (-threads) sharing elite assignments\n");
+    fprintf(stderr, "  -elites N         size of the elite pool of -coop\n");
+    fprintf(stderr, "  -elitenoise R     fraction of vars randomized when restarting from elites\n");
+    fprintf(stderr, "  -lean             skip the per-flip statistics, for speed\n");
+    fprintf(stderr, "  -undoage N        flips back within N flips count as undos\n");
+    fprintf(stderr, "  -rtd              print the run-length distribution and a suggested cutoff\n");
+    fprintf(stderr, "  -numa MODE        clause database placement: off, interleave or replicate\n");
+    fprintf(stderr, "  -pin              pin threads to cores, spread over NUMA nodes\n");
+    fprintf(stderr, "  -perf             hardware counters (cycles, cache misses, ...) per flip\n");
+    fprintf(stderr, "  -batch PATH       solve every file listed in PATH, or in directory PATH\n");
+    fprintf(stderr, "  -daemon SOCKET    serve solve requests on a unix socket, see README.txt\n");
+    fprintf(stderr, "  -cachemb N        formula cache of -daemon, in MB\n");
+    fprintf(stderr, "  -savebinary FILE  write the formula in binary, which loads faster, and exit\n");
+    fprintf(stderr, "  -seconds S        stop the search after S seconds of wall-clock time\n");
+    fprintf(stderr, "  -tryseconds S     end each try after S seconds\n");
+    fprintf(stderr, "  -checkpoint FILE  save the search to FILE on SIGUSR1, SIGTERM and SIGINT\n");
+    fprintf(stderr, "  -checkpointsec S  also save it every S seconds\n");
+    fprintf(stderr, "  -resume FILE      continue the search saved in FILE\n");
+    fprintf(stderr, "  -stats DEST       machine readable records to a file or descriptor number\n");
+    fprintf(stderr, "  -statsformat F    json (one object per line) or csv\n");
+    fprintf(stderr, "  -progress N       progress record every N flips, or N seconds with s suffix\n");
+    fprintf(stderr, "  -help             this message\n");
+}
+
+/* Accepts both -option and --option */
+void WalkSAT::parse_parameters(int argc, char** argv)
 {
     cnfStream = stdin;
+    for (int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        if (opt[0] == '-' && opt[1] == '-')
+            opt++;
+        const bool has_arg = i + 1 < argc;
+
+        if (strcmp(opt, "-seed") == 0 && has_arg) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(opt, "-cutoff") == 0 && has_arg) {
+            cutoff = parse_flips(argv[++i]);
+        } else if (strcmp(opt, "-tries") == 0 && has_arg) {
+            numrun = atoi(argv[++i]);
+        } else if (strcmp(opt, "-numsol") == 0 && has_arg) {
+            numsol = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-trace") == 0 && has_arg) {
+#ifdef WALKSAT_NO_TRACE
+            fprintf(stderr, "-trace is not available, walksat was built with WALKSAT_NO_TRACE\n");
+            exit(-1);
+#endif
+            trace_path = argv[++i];
+        } else if (strcmp(opt, "-distinct") == 0) {
+            distinct = true;
+        } else if (strcmp(opt, "-mindist") == 0 && has_arg) {
+            mindist = std::max(0, atoi(argv[++i]));
+            distinct = true;
+        } else if (strcmp(opt, "-modelformat") == 0 && has_arg) {
+            const char* name = argv[++i];
+            model_format = MODEL_LINES;
+            while (model_format <= MODEL_BITMAP && strcmp(name, model_format_name(model_format)) != 0)
+                model_format = (ModelFormat)(model_format + 1);
+            if (model_format > MODEL_BITMAP) {
+                fprintf(stderr, "Unknown model format '%s'\n", name);
+                print_usage(argv[0]);
+                exit(-1);
+            }
+        } else if (strcmp(opt, "-modelfile") == 0 && has_arg) {
+            model_path = argv[++i];
+        } else if (strcmp(opt, "-undoage") == 0 && has_arg) {
+            undo_age = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-rtd") == 0) {
+            print_rtd = true;
+        } else if (strcmp(opt, "-walkprob") == 0 && has_arg) {
+            walk_probability = atof(argv[++i]);
+        } else if (strcmp(opt, "-init") == 0 && has_arg) {
+            const char* name = argv[++i];
+            init_mode = INIT_RANDOM;
+            while (init_mode <= INIT_UNITPROP && strcmp(name, init_mode_name(init_mode)) != 0)
+                init_mode = (InitMode)(init_mode + 1);
+            if (init_mode > INIT_UNITPROP) {
+                fprintf(stderr, "Unknown initialization '%s'\n", name);
+                print_usage(argv[0]);
+                exit(-1);
+            }
+        } else if (strcmp(opt, "-initnoise") == 0 && has_arg) {
+            init_noise = atof(argv[++i]);
+        } else if (strcmp(opt, "-restart") == 0 && has_arg) {
+            const char* name = argv[++i];
+            restart_mode = RESTART_FULL;
+            while (restart_mode <= RESTART_BEST && strcmp(name, restart_mode_name(restart_mode)) != 0)
+                restart_mode = (RestartMode)(restart_mode + 1);
+            if (restart_mode > RESTART_BEST) {
+                fprintf(stderr, "Unknown restart '%s'\n", name);
+                print_usage(argv[0]);
+                exit(-1);
+            }
+        } else if (strcmp(opt, "-tune") == 0) {
+            tune = true;
+        } else if (strcmp(opt, "-tuneflips") == 0 && has_arg) {
+            tune_flips = std::max<int64_t>(1000, parse_flips(argv[++i]));
+        } else if (strcmp(opt, "-perturb") == 0 && has_arg) {
+            perturb = std::min(1.0, std::max(0.0, atof(argv[++i])));
+        } else if (strcmp(opt, "-kernel") == 0 && has_arg) {
+            const char* name = argv[++i];
+            kernel = KERNEL_SCALAR;
+            while (kernel <= KERNEL_AUTO && strcmp(name, kernel_name(kernel)) != 0)
+                kernel = (KernelType)(kernel + 1);
+            if (kernel > KERNEL_AUTO) {
+                fprintf(stderr, "Unknown kernel '%s'\n", name);
+                print_usage(argv[0]);
+                exit(-1);
+            }
+            kernel_forced = kernel != KERNEL_AUTO;
+        } else if (strcmp(opt, "-prefetch") == 0) {
+            prefetch = true;
+        } else if (strcmp(opt, "-lean") == 0) {
+            lean = true;
+        } else if (strcmp(opt, "-threads") == 0 && has_arg) {
+            numthreads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-colorflip") == 0) {
+            colorflip = true;
+        } else if (strcmp(opt, "-coop") == 0) {
+            coop_requested = true;
+        } else if (strcmp(opt, "-elites") == 0 && has_arg) {
+            numelites = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-elitenoise") == 0 && has_arg) {
+            elite_noise = atof(argv[++i]);
+        } else if (strcmp(opt, "-numa") == 0 && has_arg) {
+            const char* name = argv[++i];
+            numa_mode = NUMA_OFF;
+            while (numa_mode <= NUMA_REPLICATE && strcmp(name, numa_mode_name(numa_mode)) != 0)
+                numa_mode = (NumaMode)(numa_mode + 1);
+            if (numa_mode > NUMA_REPLICATE) {
+                fprintf(stderr, "Unknown NUMA mode '%s'\n", name);
+                print_usage(argv[0]);
+                exit(-1);
+            }
+        } else if (strcmp(opt, "-pin") == 0) {
+            pin = true;
+        } else if (strcmp(opt, "-perf") == 0) {
+            perf = true;
+        } else if (strcmp(opt, "-batch") == 0 && has_arg) {
+            batch_path = argv[++i];
+        } else if (strcmp(opt, "-daemon") == 0 && has_arg) {
+            daemon_path = argv[++i];
+        } else if (strcmp(opt, "-cachemb") == 0 && has_arg) {
+            cache_mb = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(opt, "-savebinary") == 0 && has_arg) {
+            binary_path = argv[++i];
+        } else if (strcmp(opt, "-seconds") == 0 && has_arg) {
+            time_limit = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(opt, "-tryseconds") == 0 && has_arg) {
+            try_time_limit = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(opt, "-checkpoint") == 0 && has_arg) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(opt, "-checkpointsec") == 0 && has_arg) {
+            checkpoint_every = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(opt, "-resume") == 0 && has_arg) {
+            resume_path = argv[++i];
+        } else if (strcmp(opt, "-stats") == 0 && has_arg) {
+            stats_dest = argv[++i];
+        } else if (strcmp(opt, "-statsformat") == 0 && has_arg) {
+            const char* name = argv[++i];
+            if (strcmp(name, "json") != 0 && strcmp(name, "csv") != 0) {
+                fprintf(stderr, "Unknown statistics format '%s'\n", name);
+                print_usage(argv[0]);
+                exit(-1);
+            }
+            stats_csv = strcmp(name, "csv") == 0;
+        } else if (strcmp(opt, "-progress") == 0 && has_arg) {
+            char* end;
+            progress_every = strtod(argv[++i], &end);
+            progress_in_seconds = *end == 's' || *end == 'S';
+            if (*end == 'K' || *end == 'k')
+                progress_every *= 1000;
+            else if (*end == 'M' || *end == 'm')
+                progress_every *= 1000000;
+        } else if (opt[0] != '-' && cnfStream == stdin) {
+            cnfStream = fopen(argv[i], "r");
+            if (cnfStream == NULL) {
+                fprintf(stderr, "Cannot open %s\n", argv[i]);
+                exit(-1);
+            }
+        } else {
+            print_usage(argv[0]);
+            exit(-1);
+        }
+    }
+
+    if (coop_requested && colorflip) {
+        fprintf(stderr, "-coop cannot be combined with -colorflip\n");
+        exit(-1);
+    }
+    if (coop_requested && (numsol > 1 || restart_mode != RESTART_FULL)) {
+        fprintf(stderr, "-coop cannot be combined with -numsol above 1 or -restart current/best\n");
+        exit(-1);
+    }
+    if ((batch_path != NULL || daemon_path != NULL) && (coop_requested || colorflip)) {
+        fprintf(stderr, "-batch and -daemon cannot be combined with -coop or -colorflip\n");
+        exit(-1);
+    }
+    if ((batch_path != NULL || daemon_path != NULL) && cnfStream != stdin) {
+        fprintf(stderr, "-batch and -daemon take their formulas from the list or the requests, not a cnf-file\n");
+        exit(-1);
+    }
+    if (batch_path != NULL && daemon_path != NULL) {
+        fprintf(stderr, "-batch cannot be combined with -daemon\n");
+        exit(-1);
+    }
+
+    if ((checkpoint_path != NULL || resume_path != NULL)
+        && (coop_requested || colorflip || batch_path != NULL || daemon_path != NULL)) {
+        fprintf(stderr, "-checkpoint and -resume cannot be combined with -coop, -colorflip, -batch or -daemon\n");
+        exit(-1);
+    }
+    if (trace_path != NULL && (colorflip || batch_path != NULL || daemon_path != NULL)) {
+        fprintf(stderr, "-trace cannot be combined with -colorflip, -batch or -daemon\n");
+        exit(-1);
+    }
+    if (distinct && (coop_requested || colorflip || batch_path != NULL
+                     || daemon_path != NULL || checkpoint_path != NULL || resume_path != NULL)) {
+        fprintf(stderr, "-distinct and -mindist cannot be combined with -coop, -colorflip, -batch, -daemon, "
+                        "-checkpoint or -resume\n");
+        exit(-1);
+    }
+    if (perf && (colorflip || batch_path != NULL || daemon_path != NULL)) {
+        fprintf(stderr, "-perf cannot be combined with -colorflip, -batch or -daemon\n");
+        exit(-1);
+    }
+    if (model_path != NULL && (batch_path != NULL || daemon_path != NULL)) {
+        fprintf(stderr, "-modelfile cannot be combined with -batch or -daemon\n");
+        exit(-1);
+    }
+    if (model_format == MODEL_BITMAP && model_path == NULL) {
+        fprintf(stderr, "-modelformat bitmap needs a -modelfile\n");
+        exit(-1);
+    }
+    if (tune && (coop_requested || colorflip || batch_path != NULL || daemon_path != NULL
+                 || checkpoint_path != NULL || resume_path != NULL)) {
+        fprintf(stderr, "-tune cannot be combined with -coop, -colorflip, -batch, -daemon, -checkpoint "
+                        "or -resume\n");
+        exit(-1);
+    }
+    if (checkpoint_every > 0 && checkpoint_path == NULL) {
+        fprintf(stderr, "-checkpointsec needs -checkpoint\n");
+        exit(-1);
+    }
+
+    if (kernel == KERNEL_AUTO) {
+        kernel = detect_kernel();
+    } else if (!kernel_supported(kernel)) {
+        fprintf(stderr, "Kernel %s is not supported on this CPU\n", kernel_name(kernel));
+        exit(-1);
+    }
+
     base_cutoff = cutoff;
     numerator = (int)(walk_probability * denominator);
+    init_numerator = (int)(init_noise * denominator);
 }
 
-void WalkSAT::init()
+/* Starting assignment of a try */
+void WalkSAT::init_assignment()
+{
+    if (coop && numtry % 2 == 0 && coop_seed_assignment())
+        return;
+
+    switch (init_mode) {
+        case INIT_POLARITY:
+            init_polarity();
+            break;
+        case INIT_GREEDY:
+            init_greedy();
+            break;
+        case INIT_UNITPROP:
+            init_unitprop();
+            break;
+        default:
+            for (uint32_t i = 0; i < numvars; i++)
+                assigns[i] = rng.coin() ? l_False : l_True;
+            break;
+    }
+}
+
+/* Rebuild all counters and the false list from assigns[] */
+template<int K>
+inline void WalkSAT::init_k()
 {
-    /* initialize truth assignment and changed time */
     for (uint32_t i = 0; i < numclauses; i++)
         numtruelit[i] = 0;
 
     numfalse = 0;
-    for (uint32_t i = 0; i < numvars; i++) {
+    for (uint32_t i = 0; i < numvars; i++)
         breakcount[i] = 0;
-        assigns[i] = RANDMOD(2)==0 ? l_False : l_True;
-    }
 
     /* Initialize breakcount  */
     for (uint32_t i = 0; i < numclauses; i++) {
         Lit thetruelit;
+#ifdef WALKSAT_X86_KERNELS
+        if (K == KERNEL_AVX512 && clsize[i] >= SIMD_MIN_CLAUSE) {
+            numtruelit[i] = count_true_avx512(clause[i], clsize[i], assigns, &thetruelit);
+        } else if (K == KERNEL_AVX2 && clsize[i] >= SIMD_MIN_CLAUSE) {
+            numtruelit[i] = count_true_avx2(clause[i], clsize[i], assigns, &thetruelit);
+        } else
+#endif
         for (uint32_t j = 0; j < clsize[i]; j++) {
             if (value(clause[i][j]) == l_True) {
                 numtruelit[i]++;
@@ -263,7 +1079,82 @@ void WalkSAT::init()
     }
 }
 
-void WalkSAT::initprob()
+void WalkSAT::init_scalar()
+{
+    init_k<KERNEL_SCALAR>();
+}
+
+KERNEL_AVX2_TARGET void WalkSAT::init_avx2()
+{
+    init_k<KERNEL_AVX2>();
+}
+
+KERNEL_AVX512_TARGET void WalkSAT::init_avx512()
+{
+    init_k<KERNEL_AVX512>();
+}
+
+void WalkSAT::init()
+{
+    /* with -restart the tries after the first continue the walk */
+    if (restart_mode != RESTART_FULL && numtry > 1) {
+        restart();
+        return;
+    }
+    init_assignment();
+    init_counters();
+}
+
+/* Counters and false list for the current assigns[] */
+void WalkSAT::init_counters()
+{
+    switch (kernel) {
+        case KERNEL_AVX512:
+            init_avx512();
+            break;
+        case KERNEL_AVX2:
+            init_avx2();
+            break;
+        default:
+            init_scalar();
+            break;
+    }
+    if (zobrist != NULL)
+        assign_hash = model_hash();
+}
+
+/* Stream reads without per-character locking, the parser is single threaded */
+#if defined(_WIN32)
+#define GETC_UNLOCKED getc
+#else
+#define GETC_UNLOCKED getc_unlocked
+#endif
+
+/* Reads a decimal integer after white space, like fscanf("%i") for the */
+/* numbers of a cnf file but without the scanf overhead per literal     */
+static inline bool read_int(FILE* f, int* value)
+{
+    int c;
+    do {
+        c = GETC_UNLOCKED(f);
+    } while (c == ' ' || c == '\n' || c == '\t' || c == '\r');
+
+    const bool negative = c == '-';
+    if (c == '-' || c == '+')
+        c = GETC_UNLOCKED(f);
+    if (c < '0' || c > '9')
+        return false;
+    int v = 0;
+    do {
+        v = v * 10 + (c - '0');
+        c = GETC_UNLOCKED(f);
+    } while (c >= '0' && c <= '9');
+    ungetc(c, f);
+    *value = negative ? -v : v;
+    return true;
+}
+
+bool WalkSAT::initprob()
 {
     uint32_t i;
     uint32_t j;
@@ -272,31 +1163,60 @@ void WalkSAT::initprob()
     Lit *storebase;
     uint32_t storesize;
     uint32_t storeused;
-    Lit *storeptr;
-
-    //skip header
-    while ((lastc = getc(cnfStream)) == 'c') {
-        while ((nextc = getc(cnfStream)) != EOF && nextc != '\n')
-            ;
+    BinaryHeader binhead;
+
+    /* every literal takes at least two characters, which bounds their number */
+    long filesize = -1;
+    const long start = ftell(cnfStream);
+    if (start >= 0 && fseek(cnfStream, 0, SEEK_END) == 0) {
+        filesize = ftell(cnfStream) - start;
+        fseek(cnfStream, start, SEEK_SET);
     }
-    ungetc(lastc, cnfStream);
-    if (fscanf(cnfStream, "p cnf %i %i", &numvars, &numclauses) != 2) {
-        fprintf(stderr, "Bad input file\n");
-        exit(-1);
+
+    /* a binary formula starts with a byte no cnf file starts with */
+    const bool binary = (lastc = getc(cnfStream)) == BINARY_MAGIC[0];
+    if (binary) {
+        binhead.magic[0] = (char)lastc;
+        if (fread(binhead.magic + 1, sizeof(binhead) - 1, 1, cnfStream) != 1
+            || memcmp(binhead.magic, BINARY_MAGIC, sizeof(binhead.magic)) != 0
+            || binhead.version != BINARY_VERSION) {
+            fprintf(stderr, "Bad binary formula\n");
+            return false;
+        }
+        numvars = binhead.numvars;
+        numclauses = binhead.numclauses;
+    } else {
+        //skip header
+        ungetc(lastc, cnfStream);
+        while ((lastc = getc(cnfStream)) == 'c') {
+            while ((nextc = getc(cnfStream)) != EOF && nextc != '\n')
+                ;
+        }
+        ungetc(lastc, cnfStream);
+        if (fscanf(cnfStream, "p cnf %i %i", &numvars, &numclauses) != 2) {
+            fprintf(stderr, "Bad input file\n");
+            return false;
+        }
     }
 
-    clause = (Lit **)calloc(sizeof(Lit *), numclauses);
-    clsize = (uint32_t *)calloc(sizeof(uint32_t), numclauses);
+    /* One arena for the clause database, large enough for all of it when */
+    /* the input is a file.  The literal store is allocated last so that  */
+    /* it grows in place while reading.                                    */
+    const size_t maxliterals = binary ? binhead.numliterals
+                               : filesize > 0 ? filesize / 2 : 3 * (size_t)numclauses;
+    if (formula_mem == NULL)
+        formula_mem = new Arena;
+    else
+        formula_mem->reset();  /* reuse the mappings of the previous formula */
+    formula_mem->reserve((sizeof(Lit *) + sizeof(uint32_t)) * (size_t)numclauses
+                         + (sizeof(uint32_t *) + sizeof(uint32_t)) * 2 * (size_t)numvars
+                         + (sizeof(Lit) + sizeof(uint32_t)) * maxliterals + 8 * 64);
 
-    //false-true lits
-    false_cls = (uint32_t *)calloc(sizeof(uint32_t), numclauses);
-    wherefalse = (uint32_t *)calloc(sizeof(uint32_t), numclauses);
-    numtruelit = (uint32_t *)calloc(sizeof(uint32_t), numclauses);
+    clause = formula_mem->alloc<Lit *>(numclauses, "clause pointers");
+    clsize = formula_mem->alloc<uint32_t>(numclauses, "clause sizes");
 
-    occurrence = (uint32_t **)calloc(sizeof(uint32_t *), (2 * numvars));
-    numoccurrence = (uint32_t *)calloc(sizeof(uint32_t), (2 * numvars));
-    assigns = (lbool *)calloc(sizeof(lbool), numvars);
-    breakcount = (uint32_t *)calloc(sizeof(uint32_t), numvars);
+    occurrence = formula_mem->alloc<uint32_t *>(2 * (size_t)numvars, "occurrence pointers");
+    numoccurrence = formula_mem->alloc<uint32_t>(2 * (size_t)numvars, "occurrence counts");
 
     numliterals = 0;
     longestclause = 0;
@@ -304,31 +1224,63 @@ void WalkSAT::initprob()
     /* Read in the clauses and set number of occurrences of each literal */
     storesize = 1024;
     storeused = 0;
-    printf("Reading formula\n");
-    storebase = (Lit *)calloc(sizeof(Lit), 1024);
+    if (!quiet)
+        printf("Reading formula\n");
 
     for (i = 0; i < 2 * numvars; i++)
         numoccurrence[i] = 0;
 
-    for (i = 0; i < numclauses; i++) {
+    if (binary) {
+        storesize = binhead.numliterals;
+        storebase = formula_mem->alloc<Lit>(storesize, "clause literals");
+        if (fread(clsize, sizeof(uint32_t), numclauses, cnfStream) != numclauses
+            || fread(storebase, sizeof(Lit), storesize, cnfStream) != storesize) {
+            fprintf(stderr, "Bad binary formula\n");
+            return false;
+        }
+        for (i = 0; i < numclauses; i++) {
+            if (clsize[i] == 0 || clsize[i] > storesize - numliterals) {
+                fprintf(stderr, "Bad binary formula\n");
+                return false;
+            }
+            numliterals += clsize[i];
+            longestclause = MAX(longestclause, clsize[i]);
+        }
+        for (storeused = 0; storeused < storesize; storeused++) {
+            const Lit lit = storebase[storeused];
+            if (lit.var() >= numvars) {
+                fprintf(stderr, "Bad binary formula\n");
+                return false;
+            }
+            numoccurrence[lit.toInt()]++;
+        }
+        if (numliterals != storesize) {
+            fprintf(stderr, "Bad binary formula\n");
+            return false;
+        }
+    } else {
+        storebase = formula_mem->alloc<Lit>(1024, "clause literals");
+    }
+
+    for (i = 0; i < numclauses && !binary; i++) {
         clsize[i] = 0;
         int lit;
         do {
-            if (fscanf(cnfStream, "%i ", &lit) != 1) {
+            if (!read_int(cnfStream, &lit)) {
                 fprintf(stderr, "Bad input file\n");
-                exit(-1);
+                return false;
             }
             if (lit != 0) {
                 if (storeused >= storesize) {
-                    storeptr = storebase;
-                    storebase = (Lit *)calloc(sizeof(Lit), storesize * 2);
-                    for (j = 0; j < storesize; j++)
-                        storebase[j] = storeptr[j];
-                    free((void *)storeptr);
+                    storebase = formula_mem->grow(storebase, storesize, storesize * 2, "clause literals");
                     storesize *= 2;
                 }
                 clsize[i]++;
                 const uint32_t var = std::abs(lit)-1;
+                if (var >= numvars) {
+                    fprintf(stderr, "Bad input file, variable %u out of range\n", var + 1);
+                    return false;
+                }
                 Lit real_lit = (lit > 0) ? Lit(var, false) : Lit(var, true);
                 storebase[storeused++] = real_lit;
                 numliterals++;
@@ -338,12 +1290,13 @@ void WalkSAT::initprob()
 
         if (clsize[i] == 0) {
             fprintf(stderr, "Bad input file\n");
-            exit(-1);
+            return false;
         }
         longestclause = MAX(longestclause, clsize[i]);
     }
 
-    printf("Creating data structures\n");
+    if (!quiet)
+        printf("Creating data structures\n");
 
     /* Have to wait to set the clause[i] ptrs to the end, since store might move */
     j = 0;
@@ -351,12 +1304,12 @@ void WalkSAT::initprob()
         clause[i] = &(storebase[j]);
         j += clsize[i];
     }
-    best = (int*) calloc(sizeof(int), longestclause);
 
     /* Create the occurence lists for each literal */
 
     /* First, allocate enough storage for occurrence lists */
-    uint32_t* storebase2 = (uint32_t *)calloc(sizeof(uint32_t), numliterals);
+    storebase = formula_mem->grow(storebase, storesize, storeused, "clause literals");
+    uint32_t* storebase2 = formula_mem->alloc<uint32_t>(numliterals, "occurrence lists");
 
     /* printf("numliterals = %d\n", numliterals); fflush(stdout); */
 
@@ -383,6 +1336,132 @@ void WalkSAT::initprob()
             numoccurrence[lit.toInt()]++;
         }
     }
+    return true;
+}
+
+/* Writes the formula in the binary format initprob() reads back */
+bool WalkSAT::write_binary(const char* path)
+{
+    FILE* out = fopen(path, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    BinaryHeader head;
+    memcpy(head.magic, BINARY_MAGIC, sizeof(head.magic));
+    head.version = BINARY_VERSION;
+    head.numvars = numvars;
+    head.numclauses = numclauses;
+    head.numliterals = numliterals;
+    bool ok = fwrite(&head, sizeof(head), 1, out) == 1
+              && fwrite(clsize, sizeof(uint32_t), numclauses, out) == numclauses;
+    for (uint32_t i = 0; i < numclauses && ok; i++)
+        ok = fwrite(clause[i], sizeof(Lit), clsize[i], out) == clsize[i];
+    if (fclose(out) != 0 || !ok) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+/* The search state of one walk; the clause database above can be shared */
+/* between several walkers, see coop_main()                              */
+void WalkSAT::alloc_walker()
+{
+    if (walker_mem == NULL)
+        walker_mem = new Arena;
+    else
+        walker_mem->reset();
+    walker_mem->reserve(3 * sizeof(uint32_t) * (size_t)numclauses
+                        + (sizeof(lbool) + sizeof(uint32_t)) * (size_t)numvars
+                        + sizeof(int) * longestclause + sizeof(uint32_t) * undo_age
+                        + (sizeof(lbool) + sizeof(uint32_t)) * (size_t)numvars
+                        + (numsol > 1 ? sizeof(lbool) * (size_t)numvars : 0)
+                        + (init_mode != INIT_RANDOM || restart_mode != RESTART_FULL
+                           ? 2 * sizeof(uint32_t) * (size_t)numvars : 0)
+                        + 12 * 64 + SIMD_PAD);
+
+    //false-true lits
+    false_cls = walker_mem->alloc<uint32_t>(numclauses, "false clause list");
+    wherefalse = walker_mem->alloc<uint32_t>(numclauses, "false list positions");
+    numtruelit = walker_mem->alloc<uint32_t>(numclauses, "true literal counts");
+
+    assigns = walker_mem->alloc<lbool>(numvars + SIMD_PAD, "assignment");
+    breakcount = walker_mem->alloc<uint32_t>(numvars, "breakcounts");
+    best = walker_mem->alloc<int>(longestclause, "pickbest ties");
+    undo_ring = walker_mem->alloc<uint32_t>(undo_age, "undo ring");
+    best_assigns = walker_mem->alloc<lbool>(numvars, "best assignment");
+    best_trail = walker_mem->alloc<uint32_t>(numvars, "best assignment trail");
+    if (numsol > 1)
+        solution = walker_mem->alloc<lbool>(numvars, "last solution");
+    if (init_mode == INIT_GREEDY || init_mode == INIT_UNITPROP || restart_mode != RESTART_FULL) {
+        init_order = walker_mem->alloc<uint32_t>(numvars, "initialization order");
+        for (uint32_t i = 0; i < numvars; i++)
+            init_order[i] = i;
+    }
+    if (init_mode == INIT_UNITPROP)
+        init_queue = walker_mem->alloc<uint32_t>(numvars, "propagation queue");
+}
+
+WalkSAT::~WalkSAT()
+{
+    perf_close();
+    stats_close();
+    release_memory();
+    numa_release();
+}
+
+/* Unmap everything; otherwise initprob() and alloc_walker() reuse the arenas */
+void WalkSAT::release_memory()
+{
+    delete walker_mem;
+    walker_mem = NULL;
+    delete formula_mem;
+    formula_mem = NULL;
+    clause = NULL;
+    clsize = NULL;
+    occurrence = NULL;
+    numoccurrence = NULL;
+    false_cls = NULL;
+    wherefalse = NULL;
+    numtruelit = NULL;
+    assigns = NULL;
+    breakcount = NULL;
+    best = NULL;
+    undo_ring = NULL;
+    best_assigns = NULL;
+    best_trail = NULL;
+    solution = NULL;
+    init_order = init_queue = NULL;
+    zobrist = NULL;
+    varcolor = NULL;
+    elite_buf = NULL;
+}
+
+/* Peak of the resident set: the kernel's high-water mark where it */
+/* has one, else the largest current resident set sampled          */
+void WalkSAT::sample_memory()
+{
+    double vm_usage;
+    peak_rss = std::max<uint64_t>(peak_rss, memUsedTotal(vm_usage));
+    peak_rss = std::max<uint64_t>(peak_rss, memUsedPeak());
+}
+
+void WalkSAT::print_memory()
+{
+    const Arena* arenas[2] = {formula_mem, walker_mem};
+    const char* names[2] = {"clause database", "walker state"};
+    printf("memory usage\n");
+    for (int k = 0; k < 2; k++) {
+        if (arenas[k] == NULL)
+            continue;
+        printf("  %s: %.2f MB in %.2f MB of %s pages\n", names[k], arenas[k]->used() / 1048576.0,
+               arenas[k]->mapped() / 1048576.0, Arena::page_kind_name(arenas[k]->pages()));
+        for (const Arena::Account& a : arenas[k]->accounts())
+            printf("    %-24s %12.2f MB\n", a.what, a.bytes / 1048576.0);
+    }
+    sample_memory();
+    printf("  peak resident set: %.2f MB\n", peak_rss / 1048576.0);
 }
 
 /************************************/
@@ -395,16 +1474,89 @@ void WalkSAT::print_parameters()
     printf("seed = %u\n", seed);
     printf("cutoff = %" BIGFORMAT "\n", cutoff);
     printf("tries = %i\n", numrun);
+    if (numsol > 1)
+        printf("solutions wanted = %i%s\n", numsol, distinct ? ", distinct" : "");
+    if (trace_path != NULL)
+        printf("flip trace = %s\n", trace_path);
+    if (mindist > 0)
+        printf("minimum distance between solutions = %i\n", mindist);
+    if (model_format != MODEL_LINES)
+        printf("model format = %s\n", model_format_name(model_format));
+    if (model_path != NULL)
+        printf("model file = %s\n", model_path);
     printf("walk probabability = %5.3f\n", walk_probability);
+    if (init_mode == INIT_POLARITY || init_mode == INIT_GREEDY)
+        printf("initial assignment = %s, noise %5.3f\n", init_mode_name(init_mode), init_noise);
+    else if (init_mode != INIT_RANDOM)
+        printf("initial assignment = %s\n", init_mode_name(init_mode));
+    if (tune)
+        printf("tuning = yes, %" BIGFORMAT " flips per configuration in the first round\n", tune_flips);
+    if (restart_mode != RESTART_FULL)
+        printf("restarts = from %s, perturbing %5.3f of the vars\n", restart_mode_name(restart_mode),
+               perturb);
+    printf("kernel = %s (%s)\n", kernel_name(kernel), kernel_forced ? "forced" : "detected");
+    printf("prefetching flips = %s\n", prefetch ? "yes" : "no");
+    printf("per-flip statistics = %s\n", lean ? "no" : "yes");
+    printf("threads = %i%s\n", numthreads,
+           colorflip ? ", parallel flips by var color" : coop_requested ? ", cooperative" :
+           batch_path != NULL || daemon_path != NULL ? ", one formula each" : "");
+    printf("numa = %s%s\n", numa_mode_name(numa_mode), pin ? ", threads pinned" : "");
+    if (perf)
+        printf("performance counters = yes\n");
+    if (batch_path != NULL)
+        printf("batch = %s\n", batch_path);
+    if (daemon_path != NULL)
+        printf("daemon socket = %s, formula cache = %i MB\n", daemon_path, cache_mb);
+    if (time_limit > 0)
+        printf("time limit = %g seconds\n", time_limit);
+    if (try_time_limit > 0)
+        printf("time limit per try = %g seconds\n", try_time_limit);
+    if (checkpoint_path != NULL && checkpoint_every > 0)
+        printf("checkpoint = %s, every %g seconds\n", checkpoint_path, checkpoint_every);
+    else if (checkpoint_path != NULL)
+        printf("checkpoint = %s, on signal\n", checkpoint_path);
+    if (resume_path != NULL)
+        printf("resume from = %s\n", resume_path);
+    if (stats_dest != NULL)
+        printf("statistics stream = %s, %s\n", stats_dest, stats_csv ? "csv" : "json");
+    if (coop_requested)
+        printf("elite pool = %i, elite noise = %5.3f\n", numelites, elite_noise);
     printf("\n");
 }
 
+/* Also clears what an earlier formula left, see batch_main() */
 void WalkSAT::initialize_statistics()
 {
     x = 0;
     r = 0;
+    numtry = 0;
+    found_solution = 0;
+    totalflip = 0;
+    totalsuccessflip = 0;
+    integer_sum_x = 0;
+    sum_x = 0.0;
+    mean_x = 0.0;
+    sum_r = 0;
+    mean_r = 0.0;
+    sum_avgfalse = sum_std_dev_avgfalse = 0.0;
+    number_sampled_runs = 0;
+    suc_sum_avgfalse = suc_sum_std_dev_avgfalse = 0.0;
+    suc_number_sampled_runs = 0;
+    nonsuc_sum_avgfalse = nonsuc_sum_std_dev_avgfalse = 0.0;
+    nonsuc_number_sampled_runs = 0;
+    histtotal = 0;
+    for (int b = 0; b < HISTMAX; b++) {
+        histcount[b] = 0;
+        histflips[b] = 0;
+        histsecs[b] = 0;
+    }
+    hist_censored = 0;
+    hist_censored_flips = 0;
+    best_numfalse = numclauses + 1;
+    best_pending = false;
     tail_start_flip = tail * numvars;
-    printf("tail starts after flip = %i\n", tail_start_flip);
+    if (!quiet)
+        printf("tail starts after flip = %i\n", tail_start_flip);
 }
 
 void WalkSAT::print_statistics_header()
@@ -427,10 +1579,21 @@ void WalkSAT::print_statistics_header()
 
 void WalkSAT::update_statistics_start_try()
 {
+    next_poll = POLL_INTERVAL;
     lowbad = numfalse;
     sample_size = 0;
     sumfalse = 0.0;
     sumfalse_squared = 0.0;
+    undo_count = 0;
+    undo_pos = 0;
+    for (int i = 0; i < undo_age; i++)
+        undo_ring[i] = numvars;
+    try_start = wallTime();
+    try_deadline = try_time_limit > 0 ? try_start + try_time_limit : 0;
+    perf_try_start();
+    stats_try_start();
+    if (trace != NULL)
+        trace_try_start();
 }
 
 void WalkSAT::update_statistics_end_flip()
@@ -445,8 +1608,53 @@ void WalkSAT::update_statistics_end_flip()
     }
 }
 
+/* After the flip of var; a new best restarts the trail */
+void WalkSAT::update_best(uint32_t var)
+{
+    if (numfalse < best_numfalse) {
+        best_numfalse = numfalse;
+        best_trail_len = 0;
+        best_pending = true;
+    } else if (best_pending) {
+        best_trail[best_trail_len++] = var;
+        if (best_trail_len == numvars)
+            save_best();
+    }
+}
+
+/* Brings best_assigns up to date, at the end of a try at the latest */
+void WalkSAT::save_best()
+{
+    if (best_pending) {
+        memcpy(best_assigns, assigns, sizeof(lbool) * numvars);
+        for (uint32_t i = 0; i < best_trail_len; i++)
+            best_assigns[best_trail[i]] = best_assigns[best_trail[i]] ^ true;
+        best_pending = false;
+    }
+    /* without per-flip statistics only the ends of the tries count */
+    if (numfalse < best_numfalse) {
+        best_numfalse = numfalse;
+        memcpy(best_assigns, assigns, sizeof(lbool) * numvars);
+    }
+}
+
+/* Counts flips of a var that was flipped in the last undo_age flips */
+void WalkSAT::update_undo(uint32_t var)
+{
+    for (int i = 0; i < undo_age; i++) {
+        if (undo_ring[i] == var) {
+            undo_count++;
+            break;
+        }
+    }
+    undo_ring[undo_pos] = var;
+    if (++undo_pos == (uint32_t)undo_age)
+        undo_pos = 0;
+}
+
 void WalkSAT::update_and_print_statistics_end_try()
 {
+    save_best();
     totalflip += numflip;
     x += numflip;
     r++;
@@ -482,8 +1690,11 @@ void WalkSAT::update_and_print_statistics_end_try()
         ratio_avgfalse = 0;
     }
 
+    hist_record();
     if (numfalse == 0) {
-        found_solution = true;
+        found_solution++;
+        if (solution != NULL)
+            memcpy(solution, assigns, sizeof(lbool) * numvars);
         totalsuccessflip += numflip;
         integer_sum_x += x;
         sum_x = (double)integer_sum_x;
@@ -494,24 +1705,41 @@ void WalkSAT::update_and_print_statistics_end_try()
         r = 0;
     }
 
-    //MSOOS: this has been removed, uses memory, only stats
-    double undo_fraction = 0;
+    undo_fraction = numflip > 0 ? (double)undo_count / numflip : 0;
+
+    stats_try_end();
+    perf_try_end();
 
-    printf(" %9i %9i %9.2f %9.2f %9.2f %9" BIGFORMAT " %9.6f %9i", lowbad, numfalse, avgfalse,
-           std_dev_avgfalse, ratio_avgfalse, numflip, undo_fraction,
-           ((int)found_solution * 100) / numtry);
+    if (quiet) {
+        if (numfalse == 0 && countunsat() != 0) {
+            fprintf(stderr, "Program error, verification of solution fails!\n");
+            exit(-1);
+        }
+        return;
+    }
+
+    if (lean)
+        printf(" %9s %9i %9s %9s %9s %9" BIGFORMAT " %9s %9i", "-", numfalse, "-", "-", "-",
+               numflip, "-", ((int)found_solution * 100) / numtry);
+    else
+        printf(" %9i %9i %9.2f %9.2f %9.2f %9" BIGFORMAT " %9.6f %9i", lowbad, numfalse, avgfalse,
+               std_dev_avgfalse, ratio_avgfalse, numflip, undo_fraction,
+               ((int)found_solution * 100) / numtry);
     if (found_solution) {
         printf(" %9" BIGFORMAT, totalsuccessflip / (int)found_solution);
         printf(" %11.2f", mean_x);
     }
     printf("\n");
+    perf_print_try();
 
     if (numfalse == 0 && countunsat() != 0) {
         fprintf(stderr, "Program error, verification of solution fails!\n");
         exit(-1);
     }
+    if (numfalse == 0 && models != NULL)
+        models_add();
 
-    fflush(stdout);
+    flush_progress();
 }
 
 void WalkSAT::print_statistics_final()
@@ -520,7 +1748,11 @@ void WalkSAT::print_statistics_final()
     printf("\ntotal elapsed seconds = %f\n", expertime);
     printf("num tries: %d\n", numtry);
     printf("average flips per second = %f\n", ((double)totalflip) / expertime);
+    perf_print_final();
+    stats_final();
     printf("number solutions found = %i\n", found_solution);
+    if (models != NULL)
+        printf("distinct solutions found = %i\n", models_found);
     printf("final success rate = %f\n", ((double)found_solution * 100.0) / numtry);
     printf("average length successful tries = %" BIGFORMAT "\n",
            found_solution ? (totalsuccessflip / found_solution) : 0);
@@ -533,6 +1765,8 @@ void WalkSAT::print_statistics_final()
         printf("mean seconds until assign = %f\n", mean_x * seconds_per_flip);
         printf("mean restarts until assign = %f\n", mean_r);
     }
+    if (print_rtd)
+        print_run_lengths();
 
     if (number_sampled_runs) {
         mean_avgfalse = sum_avgfalse / number_sampled_runs;
@@ -577,27 +1811,42 @@ void WalkSAT::print_statistics_final()
                nonsuc_ratio_mean_avgfalse);
     }
 
+    print_memory();
+
     if (found_solution) {
         printf("ASSIGNMENT FOUND\n");
-        print_sol_cnf();
-    } else
+        /* with -distinct every model was written when found */
+        if (models == NULL)
+            print_sol_cnf();
+    } else {
         printf("ASSIGNMENT NOT FOUND\n");
-}
-
-void WalkSAT::print_sol_cnf()
-{
-    for (uint32_t i = 0; i < numvars; i++)
-        printf("v %i\n", assigns[i] == l_True? ((int)i+1) : -1*((int)i+1));
+        if (stopped && best_numfalse <= numclauses) {
+            printf("BEST ASSIGNMENT SO FAR, %u FALSE CLAUSES\n", best_numfalse);
+            memcpy(assigns, best_assigns, sizeof(lbool) * numvars);
+            print_sol_cnf();
+        }
+    }
 }
 
 /*******************************************************/
 /* Utility Functions                                   */
 /*******************************************************/
 
-uint32_t WalkSAT::countunsat()
+template<int K>
+inline uint32_t WalkSAT::countunsat_k()
 {
     uint32_t unsat = 0;
     for (uint32_t i = 0; i < numclauses; i++) {
+#ifdef WALKSAT_X86_KERNELS
+        if (K == KERNEL_AVX512 && clsize[i] >= SIMD_MIN_CLAUSE) {
+            unsat += !clause_sat_avx512(clause[i], clsize[i], assigns);
+            continue;
+        }
+        if (K == KERNEL_AVX2 && clsize[i] >= SIMD_MIN_CLAUSE) {
+            unsat += !clause_sat_avx2(clause[i], clsize[i], assigns);
+            continue;
+        }
+#endif
         bool bad = true;
         for (uint32_t j = 0; j < clsize[i]; j++) {
             Lit lit = clause[i][j];
@@ -612,21 +1861,56 @@ uint32_t WalkSAT::countunsat()
     return unsat;
 }
 
+uint32_t WalkSAT::countunsat_scalar()
+{
+    return countunsat_k<KERNEL_SCALAR>();
+}
+
+KERNEL_AVX2_TARGET uint32_t WalkSAT::countunsat_avx2()
+{
+    return countunsat_k<KERNEL_AVX2>();
+}
+
+KERNEL_AVX512_TARGET uint32_t WalkSAT::countunsat_avx512()
+{
+    return countunsat_k<KERNEL_AVX512>();
+}
+
+uint32_t WalkSAT::countunsat()
+{
+    switch (kernel) {
+        case KERNEL_AVX512:
+            return countunsat_avx512();
+        case KERNEL_AVX2:
+            return countunsat_avx2();
+        default:
+            return countunsat_scalar();
+    }
+}
+
 /****************************************************************/
 /*                  Heuristics                                  */
 /****************************************************************/
 
-uint32_t WalkSAT::pickbest()
+template<int K>
+inline uint32_t WalkSAT::pickbest()
 {
     uint32_t tofix;
     uint32_t clausesize;
     uint32_t i;
 
-    tofix = false_cls[RANDMOD(numfalse)];
+    tofix = false_cls[rng.below(numfalse)];
     clausesize = clsize[tofix];
     uint32_t numbest = 0;
     uint32_t bestvalue = std::numeric_limits<uint32_t>::max();
 
+#ifdef WALKSAT_X86_KERNELS
+    if (K == KERNEL_AVX512 && clausesize >= SIMD_MIN_CLAUSE) {
+        bestvalue = min_break_avx512(clause[tofix], clausesize, breakcount, best, &numbest);
+    } else if (K == KERNEL_AVX2 && clausesize >= SIMD_MIN_CLAUSE) {
+        bestvalue = min_break_avx2(clause[tofix], clausesize, breakcount, best, &numbest);
+    } else
+#endif
     for (i = 0; i < clausesize; i++) {
         uint32_t var = clause[tofix][i].var();
         uint32_t numbreak = breakcount[var];
@@ -638,8 +1922,21 @@ uint32_t WalkSAT::pickbest()
         }
     }
 
-    if ((bestvalue > 0) && (RANDMOD(denominator) < numerator))
-        return clause[tofix][RANDMOD(clausesize)].var();
+    if ((bestvalue > 0) && (rng.below(denominator) < (uint32_t)numerator))
+        return clause[tofix][rng.below(clausesize)].var();
+
+    return ABS(best[rng.below(numbest)]);
+}
 
-    return ABS(best[RANDMOD(numbest)]);
+/* pickbest() for callers outside the per-kernel flip loops */
+uint32_t WalkSAT::pickvar()
+{
+    switch (kernel) {
+        case KERNEL_AVX512:
+            return pickbest<KERNEL_AVX512>();
+        case KERNEL_AVX2:
+            return pickbest<KERNEL_AVX2>();
+        default:
+            return pickbest<KERNEL_SCALAR>();
+    }
 }
@@ -27,25 +27,262 @@ THE SOFTWARE.
 #include <cstdint>
 #include <cstdio>
 #include "solvertypesmini.h"
+#include "walksat_arena.h"
+#include "walksat_rng.h"
+
+/* Per instruction set copies of the hot kernels are compiled into the */
+/* same binary and one is selected at startup, see WalkSAT::kernel     */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define WALKSAT_X86_KERNELS 1
+#define KERNEL_AVX2_TARGET __attribute__((target("avx2")))
+#define KERNEL_AVX512_TARGET __attribute__((target("avx2,avx512f")))
+#else
+#define KERNEL_AVX2_TARGET
+#define KERNEL_AVX512_TARGET
+#endif
 
 namespace CMSat {
 
+struct ColorFlipState;
+struct CoopState;
+struct NumaState;
+struct PerfState;
+struct StatsStream;
+struct BatchState;
+struct CachedFormula;
+struct DaemonState;
+struct TuneConfig;
+struct ModelSet;
+struct TraceState;
+class OutputBuffer;
+
+enum KernelType { KERNEL_SCALAR = 0, KERNEL_AVX2 = 1, KERNEL_AVX512 = 2, KERNEL_AUTO = 3 };
+enum NumaMode { NUMA_OFF = 0, NUMA_INTERLEAVE = 1, NUMA_REPLICATE = 2 };
+enum InitMode { INIT_RANDOM = 0, INIT_POLARITY = 1, INIT_GREEDY = 2, INIT_UNITPROP = 3 };
+enum RestartMode { RESTART_FULL = 0, RESTART_CURRENT = 1, RESTART_BEST = 2 };
+enum ModelFormat { MODEL_LINES = 0, MODEL_PACKED = 1, MODEL_BITMAP = 2 };
+
 class WalkSAT {
+    friend class MicroBench;
+
 public:
-    int main();
+    ~WalkSAT();
+    int main(int argc, char** argv);
+    void release_memory();
 
 private:
     /************************************/
     /* Main                             */
     /************************************/
-    void flipvar(uint32_t toflip);
+    template<class Work> void flipvar(uint32_t toflip);
+    template<class Work> void flipvar_pipelined(uint32_t toflip);
+
+    /* Policies of flip_loop_k(), fixed for a whole try so that the */
+    /* compiler drops whatever a policy does not use                */
+    struct FullStats {
+        static void end_flip(WalkSAT& s, uint32_t var)
+        {
+            s.update_undo(var);
+            s.update_best(var);
+            s.update_statistics_end_flip();
+        }
+    };
+    struct LeanStats {
+        static void end_flip(WalkSAT&, uint32_t) {}
+    };
+    struct NoWork {
+        static void visited(WalkSAT&, uint32_t) {}
+        static void rescan(WalkSAT&) {}
+    };
+    struct CountWork {  /* -perf: occurrences visited and clauses rescanned */
+        static void visited(WalkSAT& s, uint32_t numocc) { s.occ_visited += numocc; }
+        static void rescan(WalkSAT& s) { s.clause_rescans++; }
+    };
+    template<class Work> struct PlainFlip {
+        static void flip(WalkSAT& s, uint32_t var) { s.flipvar<Work>(var); }
+    };
+    template<class Work> struct PipelinedFlip {
+        static void flip(WalkSAT& s, uint32_t var) { s.flipvar_pipelined<Work>(var); }
+    };
+    struct NoTrace {
+        static void record(WalkSAT&, uint32_t) {}
+    };
+#ifndef WALKSAT_NO_TRACE
+    struct TraceFlips {
+        static void record(WalkSAT& s, uint32_t var) { s.trace_record(var, s.numfalse); }
+    };
+#endif
+
+    void run_tries();
+    void flip_loop();
+    template<int K, class Stats, class Flip, class Trace> void flip_loop_k();
+    template<int K, class Trace, class Work> void flip_loop_stats();
+    template<int K, class Trace> void flip_loop_work();
+    template<int K> void flip_loop_policy();
+    void replay_flips(const uint32_t* vars, uint32_t n);
+    void flip_loop_scalar();
+    KERNEL_AVX2_TARGET void flip_loop_avx2();
+    KERNEL_AVX512_TARGET void flip_loop_avx512();
+    bool poll();
+    bool budget_exhausted();
+    static void install_stop_handlers();
+
+    /************************************/
+    /* Parallel flipping by var color   */
+    /************************************/
+    void color_vars();
+    void colorflip_start();
+    void colorflip_stop();
+    void colorflip_loop();
+    void colorflip_worker(uint32_t thread);
+    void colorflip_work(uint32_t thread);
+    uint32_t colorflip_pick(uint32_t tofix, uint32_t thread);
+    void colorflip_flip(uint32_t var, uint32_t thread);
+    void flipvar_concurrent(uint32_t toflip, uint32_t thread);
+
+    /************************************/
+    /* Cooperative workers              */
+    /************************************/
+    void coop_main();
+    void coop_search();
+    bool coop_poll();
+    void coop_offer();
+    bool coop_publish();
+    bool coop_seed_assignment();
+
+    /************************************/
+    /* Batch of formulas                */
+    /************************************/
+    int batch_main();
+    void batch_worker(uint32_t thread);
+
+    /************************************/
+    /* Solver daemon                    */
+    /************************************/
+    int daemon_main();
+    void daemon_worker(uint32_t thread);
+    void daemon_serve(int conn);
+    CachedFormula* daemon_load(FILE* stream);
+
+    /************************************/
+    /* Flip trace                       */
+    /************************************/
+    void trace_open();
+    void trace_close();
+    void trace_try_start();
+    void trace_publish();
+    void trace_record(uint32_t a, uint32_t b)
+    {
+        uint32_t* rec = trace_ring + 2 * (trace_pos & trace_mask);
+        rec[0] = a;
+        rec[1] = b;
+        if ((++trace_pos & (TRACE_CHUNK - 1)) == 0)
+            trace_publish();
+    }
+    static const uint32_t TRACE_TRY = 0xffffffff;  /* first word of a try's first record */
+    static const uint32_t TRACE_RESTART = 0xfffffffe; /* first word before a restart's flips */
+    static const uint32_t TRACE_CHUNK = 1 << 16;   /* records handed to the writer at once */
+
+    /************************************/
+    /* Distinct solutions               */
+    /************************************/
+    void models_open();
+    void models_close();
+    void models_add();
+    uint64_t model_hash() const;
+
+    /************************************/
+    /* Parameter tuning                 */
+    /************************************/
+    void tune_parameters();
+    void tune_probe(TuneConfig& c, int64_t budget);
+
+    /************************************/
+    /* Checkpoint and resume            */
+    /************************************/
+    void checkpoint_setup();
+    void checkpoint_poll();
+    void checkpoint_write();
+    void checkpoint_read();
+    bool checkpoint_state(FILE* f, bool save, double& seconds);
+    uint64_t formula_fingerprint() const;
+
+    /************************************/
+    /* NUMA placement                   */
+    /************************************/
+    void numa_setup();
+    void numa_place_formula();
+    int numa_pin_thread(uint32_t thread);
+    void numa_attach_formula(int node);
+    void numa_release();
+    static const char* numa_mode_name(NumaMode mode);
+
+    /************************************/
+    /* Hardware performance counters    */
+    /************************************/
+    void perf_open();
+    void perf_close();
+    void perf_try_start();
+    void perf_try_end();
+    void perf_print_try();
+    void perf_print_final();
+
+    /************************************/
+    /* Machine readable statistics      */
+    /************************************/
+    void stats_open();
+    void stats_close();
+    void stats_try_start();
+    void stats_progress();
+    void stats_try_end();
+    void stats_final();
+    void stats_instance(const char* file, const char* status, double parse_seconds,
+                        FILE* out = NULL);
+
+    /************************************/
+    /* Run-length distribution          */
+    /************************************/
+    static int hist_bucket(int64_t flips);
+    static int64_t hist_bucket_end(int b);
+    void hist_record();
+    bool hist_suggest_cutoff(int64_t& best_cutoff, double& expected);
+    bool hist_tail_index(double& alpha);
+    void print_run_lengths();
+
+    /************************************/
+    /* Kernel selection                 */
+    /************************************/
+    static KernelType detect_kernel();
+    static bool kernel_supported(KernelType k);
+    static const char* kernel_name(KernelType k);
 
     /************************************/
     /* Initialization                   */
     /************************************/
-    void parse_parameters();
+    void parse_parameters(int argc, char** argv);
+    void print_usage(const char* prog);
     void init();
-    void initprob();
+    void init_assignment();
+    void init_polarity();
+    void init_greedy();
+    void init_unitprop();
+    void init_shuffle();
+    bool init_noisy();
+    void init_enqueue(Lit lit, uint32_t& qtail);
+    static const char* init_mode_name(InitMode mode);
+    void restart();
+    void restart_flips(const uint32_t* vars, uint32_t n);
+    static const char* restart_mode_name(RestartMode mode);
+    void init_counters();
+    template<int K> void init_k();
+    void init_scalar();
+    KERNEL_AVX2_TARGET void init_avx2();
+    KERNEL_AVX512_TARGET void init_avx512();
+    bool initprob();
+    bool write_binary(const char* path);
+    void alloc_walker();
+    void sample_memory();
+    void print_memory();
 
     /************************************/
     /* Printing and Statistics          */
@@ -55,19 +292,32 @@ private:
     void print_statistics_header();
     void update_statistics_start_try();
     void update_statistics_end_flip();
+    void update_undo(uint32_t var);
+    void update_best(uint32_t var);
+    void save_best();
     void update_and_print_statistics_end_try();
     void print_statistics_final();
     void print_sol_cnf();
+    void write_model(OutputBuffer& out, ModelFormat format, bool wrap);
+    void model_output_open();
+    void model_output_close();
+    void flush_progress();
+    static const char* model_format_name(ModelFormat format);
 
     /*******************************************************/
     /* Utility Functions                                   */
     /*******************************************************/
     uint32_t countunsat();
+    template<int K> uint32_t countunsat_k();
+    uint32_t countunsat_scalar();
+    KERNEL_AVX2_TARGET uint32_t countunsat_avx2();
+    KERNEL_AVX512_TARGET uint32_t countunsat_avx512();
 
     /****************************************************************/
     /*                  Heuristics                                  */
     /****************************************************************/
-    uint32_t pickbest();
+    template<int K> uint32_t pickbest();
+    uint32_t pickvar();
 
     /************************************/
     /* Main data structures             */
@@ -84,6 +334,11 @@ private:
     uint32_t numliterals; /* number of instances of literals across all clauses */
     uint32_t numfalse;   /* number of false clauses */
 
+    /* All arrays below come from these, see initprob() and alloc_walker() */
+    Arena *formula_mem = NULL;  /* read-only clause database, shared by walkers */
+    Arena *walker_mem = NULL;   /* search state of this walker */
+    uint64_t peak_rss = 0;      /* resident set high-water mark, see sample_memory() */
+
     /* Data structures for clauses */
 
     Lit **clause; /* clauses to be satisfied */
@@ -111,17 +366,101 @@ private:
     /* Data structures for lists of clauses used in heuristics */
     int *best;
 
+    /* Scratch of the starting assignments, see walksat_init.cpp */
+    uint32_t *init_order = NULL;  /* vars in random order, greedy, unitprop and restarts */
+    uint32_t *init_queue = NULL;  /* vars to propagate, unitprop */
+
+    /* Parallel flipping, see colorflip_loop() */
+    uint32_t *varcolor;     /* vars of one color share no clause */
+    uint32_t numcolors;
+    ColorFlipState *cf = NULL;
+
+    /* Cooperative workers, see coop_main() */
+    CoopState *coop = NULL;  /* shared by all workers, NULL when not cooperating */
+    int worker_id = 0;
+    uint64_t *elite_buf = NULL; /* scratch for reading elites */
+    uint32_t coop_offered = UINT32_MAX; /* best_numfalse last offered to the elites */
+    bool shared_clauses = false; /* clause[] is read by other workers, keep literal order */
+    bool quiet = false;          /* no per-try or progress output */
+    int64_t next_poll;           /* numflip at which poll() is called next */
+    double deadline = 0;         /* wallTime() at which the search stops, 0 for none */
+    double try_deadline = 0;     /* wallTime() at which the try is abandoned, 0 for none */
+    double try_start = 0;        /* wallTime() at which the try started */
+    bool stopped = false;        /* a time limit or a signal ended the search */
+    const char *stop_reason = NULL;
+    FILE *model_out = NULL;      /* -modelfile, opened by model_output_open() */
+    double next_flush = 0;       /* wallTime() at which stdout is flushed next */
+
+    /* Shared by the workers of batch_main(), NULL otherwise */
+    BatchState *batch = NULL;
+    DaemonState *dstate = NULL;   /* same for daemon_main() */
+
+    /* Checkpoints, see walksat_checkpoint.cpp */
+    double next_checkpoint = 0;   /* wallTime() of the next periodic checkpoint, 0 for none */
+    double resumed_seconds = 0;   /* CPU time before the resumed checkpoint */
+    bool resuming = false;        /* run_tries() continues the restored try */
+
+    /* Clause database copies and cpu topology, see numa_place_formula() */
+    NumaState *numa = NULL;
+
+    /* Counters of the search, see walksat_perf.cpp */
+    PerfState *perfstate = NULL;  /* NULL without -perf */
+    uint64_t occ_visited = 0;     /* occurrences walked by flipvar(), with -perf */
+    uint64_t clause_rescans = 0;  /* clauses scanned for their true literal, with -perf */
+
+    /* Records for -stats, see walksat_stats.cpp */
+    StatsStream *stats = NULL;    /* NULL without -stats */
+
     /************************************/
     /* Global flags and parameters      */
     /************************************/
 
     /* Options */
     FILE *cnfStream;
+    KernelType kernel = KERNEL_AUTO;   /* instruction set of the hot kernels */
+    bool kernel_forced = false;         /* set with -kernel, not detected */
+    bool prefetch = false;              /* use flipvar_pipelined() */
+    bool lean = false;                  /* no per-flip statistics */
+    bool colorflip = false;             /* flip non-adjacent vars in parallel */
+    int numthreads = 1;
+    bool coop_requested = false;        /* -coop */
+    int numelites = 8;
+    double elite_noise = 0.1;
+    NumaMode numa_mode = NUMA_OFF;      /* placement of the clause database */
+    InitMode init_mode = INIT_RANDOM;   /* starting assignment of the tries */
+    double init_noise = 0.1;            /* vars left to a coin flip by polarity and greedy */
+    int init_numerator = 0;             /* init_noise over denominator */
+    RestartMode restart_mode = RESTART_FULL; /* where the tries after the first start */
+    double perturb = 0.05;              /* fraction of vars flipped by a restart */
+    const char *trace_path = NULL;      /* -trace file */
+    bool distinct = false;              /* -numsol counts distinct models */
+    int mindist = 0;                    /* vars by which models must differ, with -distinct */
+    ModelFormat model_format = MODEL_LINES; /* how print_sol_cnf() writes a model */
+    const char *model_path = NULL;      /* -modelfile, stdout if NULL */
+    bool tune = false;                  /* -tune the parameters before the search */
+    int64_t tune_flips = 50000;         /* flips per configuration in the first round */
+    bool pin = false;                   /* pin threads to cores */
+    bool perf = false;                  /* hardware counters per try */
+    const char *stats_dest = NULL;      /* -stats file name or descriptor */
+    bool stats_csv = false;             /* CSV rows instead of JSON lines */
+    double progress_every = 0;          /* flips, or seconds, between progress records */
+    bool progress_in_seconds = false;
+    const char *batch_path = NULL;      /* -batch list file or directory */
+    const char *daemon_path = NULL;     /* -daemon socket */
+    int cache_mb = 1024;                /* -daemon formula cache size */
+    const char *binary_path = NULL;     /* -savebinary output */
+    const char *checkpoint_path = NULL; /* -checkpoint file */
+    double checkpoint_every = 0;        /* seconds between checkpoints, 0 for on signal only */
+    const char *resume_path = NULL;     /* -resume file */
+    double time_limit = 0;              /* -seconds, for the whole run */
+    double try_time_limit = 0;          /* -tryseconds, for each try */
 
     int numerator; /* make random flip with numerator/denominator frequency */
     double walk_probability = 0.5;
     int64_t numflip;        /* number of changes so far */
     int numrun = 10;
+    int numsol = 1;         /* solutions to find before stopping */
+    bool print_rtd = false; /* print the run-length distribution */
     int64_t cutoff = 100000;
     int64_t base_cutoff = 100000;
     int numtry = 0;   /* total attempts at solutions */
@@ -130,13 +469,46 @@ private:
 
     /* Random seed */
     unsigned int seed; /* Sometimes defined as an unsigned long int */
-
-    /* Histogram of tail */
-    static const int HISTMAX=64;         /* length of histogram of tail */
-    long histtotal;
+    Rng rng;           /* this walker's stream of (seed, worker_id) */
+
+    /* Run lengths of the tries, two log buckets per power of two */
+    static const int HISTMAX=64;         /* number of buckets, the last one is open */
+    long histtotal = 0;                  /* tries recorded */
+    int64_t histcount[HISTMAX] = {};     /* successful tries per bucket */
+    double histflips[HISTMAX] = {};      /* their flips */
+    double histsecs[HISTMAX] = {};       /* the longest wall time of one of them */
+    int64_t hist_censored = 0;           /* tries stopped without a solution */
+    double hist_censored_flips = 0;      /* their flips */
     int tail = 10;
     int tail_start_flip;
+
+    /* Undo fraction: flips of a var flipped in the last undo_age flips */
     int undo_age = 1;
+    uint32_t *undo_ring = NULL;   /* the last undo_age flipped vars */
+    uint32_t undo_pos;
+    int64_t undo_count;           /* undoing flips this try */
+    double undo_fraction = 0;     /* of the flips of the last try */
+
+    /* Flip trace, see walksat_trace.cpp */
+    TraceState *trace = NULL;     /* NULL without -trace */
+    uint32_t *trace_ring = NULL;  /* two words per record */
+    uint64_t trace_mask = 0;
+    uint64_t trace_pos = 0;       /* records stored so far */
+
+    /* Distinct solutions, see walksat_models.cpp */
+    ModelSet *models = NULL;      /* NULL without -distinct */
+    uint64_t *zobrist = NULL;     /* hash key of each var */
+    uint64_t assign_hash = 0;     /* of assigns[], kept by flipvar() when zobrist is set */
+    int models_found = 0;         /* distinct models */
+
+    /* Best assignment of all tries, for a search stopped without a solution. */
+    /* Copied lazily: after a new best the flipped vars are logged, and the  */
+    /* copy is taken by undoing them once they are numvars or the try ends.  */
+    lbool *best_assigns = NULL;
+    uint32_t best_numfalse;       /* numclauses + 1 before the first try */
+    uint32_t *best_trail = NULL;  /* vars flipped since the best, if best_pending */
+    uint32_t best_trail_len = 0;
+    bool best_pending = false;    /* best_assigns is behind, see save_best() */
 
     /* Statistics */
 
@@ -145,7 +517,8 @@ private:
     uint32_t lowbad;                  /* lowest number of bad clauses during try */
     int64_t totalflip = 0;        /* total number of flips in all tries so far */
     int64_t totalsuccessflip = 0; /* total number of flips in all tries which succeeded so far */
-    bool found_solution = 0;       /* total found solutions */
+    int found_solution = 0;       /* total found solutions */
+    lbool *solution = NULL;       /* last solution found, kept with -numsol above 1 */
     int64_t x;
     int64_t integer_sum_x = 0;
     double sum_x = 0.0;
@@ -0,0 +1,226 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "walksat_arena.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace CMSat;
+
+#define ARENA_ALIGN 64                 /* cache line, and enough for any SIMD load */
+#define HUGE_PAGE (2UL * 1024 * 1024)
+#define MIN_CHUNK (1UL * 1024 * 1024)  /* smallest chunk mapped when the arena runs out */
+
+static inline size_t round_up(size_t x, size_t to)
+{
+    return (x + to - 1) / to * to;
+}
+
+Arena::~Arena()
+{
+    for (const Chunk& c : chunks) {
+#ifdef __linux__
+        munmap(c.base, c.size);
+#else
+        free(c.raw);
+#endif
+    }
+}
+
+void Arena::reserve(size_t bytes)
+{
+    next_chunk = bytes;
+}
+
+void Arena::set_policy(int mode, uint64_t nodemask)
+{
+    policy_mode = mode;
+    policy_nodes = nodemask;
+}
+
+void Arena::map_chunk(size_t bytes)
+{
+    Chunk c;
+    c.used = 0;
+    c.dirty = 0;
+#ifdef __linux__
+    c.size = round_up(bytes, HUGE_PAGE);
+    c.kind = PAGES_HUGETLB;
+    void* mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    /* only succeeds if enough huge pages are reserved, see vm.nr_hugepages */
+    mem = mmap(NULL, c.size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (mem == MAP_FAILED) {
+        /* over-map by one huge page so the chunk can start on a 2MB boundary */
+        c.kind = PAGES_NORMAL;
+        char* raw = (char *)mmap(NULL, c.size + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            fprintf(stderr, "Out of memory mapping %zu bytes\n", c.size);
+            exit(-1);
+        }
+        char* aligned = (char *)round_up((uintptr_t)raw, HUGE_PAGE);
+        if (aligned > raw)
+            munmap(raw, aligned - raw);
+        munmap(aligned + c.size, raw + HUGE_PAGE - aligned);
+        mem = aligned;
+#ifdef MADV_HUGEPAGE
+        if (madvise(mem, c.size, MADV_HUGEPAGE) == 0)
+            c.kind = PAGES_TRANSPARENT;
+#endif
+    }
+    if (policy_mode != 0) {
+        unsigned long mask = policy_nodes;
+        if (syscall(SYS_mbind, mem, c.size, policy_mode, &mask, 65, 0) != 0)
+            perror("mbind");
+    }
+    c.base = (char *)mem;
+    c.raw = mem;
+#else
+    c.size = round_up(bytes, ARENA_ALIGN);
+    c.kind = PAGES_NORMAL;
+    c.raw = calloc(c.size + ARENA_ALIGN, 1);
+    if (c.raw == NULL) {
+        fprintf(stderr, "Out of memory allocating %zu bytes\n", c.size);
+        exit(-1);
+    }
+    c.base = (char *)round_up((uintptr_t)c.raw, ARENA_ALIGN);
+#endif
+    chunks.push_back(c);
+}
+
+void Arena::account(const char* what, ptrdiff_t bytes)
+{
+    for (Account& a : usage) {
+        if (strcmp(a.what, what) == 0) {
+            a.bytes += bytes;
+            return;
+        }
+    }
+    usage.push_back(Account{what, (size_t)bytes});
+}
+
+void* Arena::alloc_bytes(size_t bytes, const char* what)
+{
+    const size_t size = round_up(std::max<size_t>(bytes, 1), ARENA_ALIGN);
+    /* a rewound arena refills its chunks in order */
+    size_t k = 0;
+    while (k < chunks.size() && chunks[k].used + size > chunks[k].size)
+        k++;
+    if (k == chunks.size()) {
+        map_chunk(std::max(std::max(next_chunk, size), (size_t)MIN_CHUNK));
+        next_chunk = 0;
+    }
+
+    Chunk& c = chunks[k];
+    char* p = c.base + c.used;
+    if (c.used < c.dirty)
+        memset(p, 0, std::min(size, c.dirty - c.used));
+    c.used += size;
+    c.dirty = std::max(c.dirty, c.used);
+    last = p;
+    account(what, bytes);
+    return p;
+}
+
+void* Arena::grow_bytes(void* p, size_t bytes, size_t newbytes, const char* what)
+{
+    if (p == last && !chunks.empty()) {
+        for (Chunk& c : chunks) {
+            const size_t start = (char *)p - c.base;
+            if ((char *)p < c.base || start >= c.size || start + round_up(bytes, ARENA_ALIGN) != c.used)
+                continue;
+            const size_t size = round_up(newbytes, ARENA_ALIGN);
+            if (start + size > c.size)
+                break;
+            if (start + size > c.used && c.used < c.dirty)
+                memset(c.base + c.used, 0, std::min(start + size, c.dirty) - c.used);
+            c.used = start + size;
+            c.dirty = std::max(c.dirty, c.used);
+            account(what, (ptrdiff_t)newbytes - (ptrdiff_t)bytes);
+            return p;
+        }
+    }
+
+    /* the old copy stays in the arena until reset() */
+    void* q = alloc_bytes(newbytes, what);
+    memcpy(q, p, std::min(bytes, newbytes));
+    account(what, -(ptrdiff_t)bytes);
+    account("outgrown copies", bytes);
+    return q;
+}
+
+void Arena::reset()
+{
+    for (Chunk& c : chunks)
+        c.used = 0;
+    usage.clear();
+    last = NULL;
+}
+
+size_t Arena::mapped() const
+{
+    size_t total = 0;
+    for (const Chunk& c : chunks)
+        total += c.size;
+    return total;
+}
+
+size_t Arena::used() const
+{
+    size_t total = 0;
+    for (const Chunk& c : chunks)
+        total += c.used;
+    return total;
+}
+
+/* The weakest kind of page among the chunks */
+Arena::PageKind Arena::pages() const
+{
+    if (chunks.empty())
+        return PAGES_NONE;
+    PageKind kind = PAGES_HUGETLB;
+    for (const Chunk& c : chunks)
+        kind = std::min(kind, c.kind);
+    return kind;
+}
+
+const char* Arena::page_kind_name(PageKind kind)
+{
+    switch (kind) {
+        case PAGES_NONE: return "none";
+        case PAGES_NORMAL: return "normal";
+        case PAGES_TRANSPARENT: return "transparent huge";
+        case PAGES_HUGETLB: return "2MB huge";
+    }
+    return "?";
+}
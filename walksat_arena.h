@@ -0,0 +1,119 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+#ifndef WALKSAT_ARENA_H
+#define WALKSAT_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace CMSat {
+
+/********************************************************************/
+/* Bump allocator for the solver arrays.                            */
+/*                                                                  */
+/* Memory comes in large chunks mapped with 2MB huge pages when the */
+/* system has them reserved (MAP_HUGETLB), else with transparent    */
+/* huge pages requested through madvise.  The first chunk is sized  */
+/* by the caller, so normally everything lives in one mapping.      */
+/* Arrays are zeroed, 64-byte aligned, and are never freed one by   */
+/* one: reset() rewinds the arena for reuse, the destructor unmaps  */
+/* it.  Bytes are accounted per structure name.                     */
+/********************************************************************/
+
+class Arena
+{
+public:
+    enum PageKind { PAGES_NONE = 0, PAGES_NORMAL = 1, PAGES_TRANSPARENT = 2, PAGES_HUGETLB = 3 };
+
+    Arena() {}
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /* Size of the next chunk to map; call before the first alloc() */
+    void reserve(size_t bytes);
+
+    /* NUMA policy (see mbind(2)) of chunks mapped from now on */
+    void set_policy(int mode, uint64_t nodemask);
+
+    template<class T>
+    T* alloc(size_t n, const char* what)
+    {
+        return (T*)alloc_bytes(n * sizeof(T), what);
+    }
+
+    /* Resize the array p of n elements to newn, in place if it is the */
+    /* last allocation and its chunk has room                          */
+    template<class T>
+    T* grow(T* p, size_t n, size_t newn, const char* what)
+    {
+        return (T*)grow_bytes(p, n * sizeof(T), newn * sizeof(T), what);
+    }
+
+    void reset();
+    size_t mapped() const;
+    size_t used() const;
+    PageKind pages() const;
+    static const char* page_kind_name(PageKind kind);
+
+    /* Bytes per structure name, in order of first allocation */
+    struct Account
+    {
+        const char* what;
+        size_t bytes;
+    };
+    const std::vector<Account>& accounts() const
+    {
+        return usage;
+    }
+
+private:
+    struct Chunk
+    {
+        char* base;
+        void* raw;    /* what to unmap or free */
+        size_t size;
+        size_t used;
+        size_t dirty; /* bytes written since mapping, must be zeroed on reuse */
+        PageKind kind;
+    };
+
+    void* alloc_bytes(size_t bytes, const char* what);
+    void* grow_bytes(void* p, size_t bytes, size_t newbytes, const char* what);
+    void map_chunk(size_t bytes);
+    void account(const char* what, ptrdiff_t bytes);
+
+    std::vector<Chunk> chunks;
+    std::vector<Account> usage;
+    size_t next_chunk = 0;
+    void* last = NULL;        /* most recent allocation, can grow in place */
+    int policy_mode = 0;
+    uint64_t policy_nodes = 0;
+};
+
+}
+
+#endif //WALKSAT_ARENA_H
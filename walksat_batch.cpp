@@ -0,0 +1,207 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Batch mode: many formulas in one process, with -batch PATH.      */
+/*                                                                  */
+/* PATH is a file listing one cnf file per line, or a directory     */
+/* whose files are solved in name order.  -threads N workers take   */
+/* the next formula from a shared counter.  A worker keeps its two  */
+/* arenas from one formula to the next, see Arena::reset(), so      */
+/* after the first few formulas it maps no memory at all.  Each     */
+/* formula is solved as by a run of its own with the same options   */
+/* and seed, whatever worker gets it, and gives one "instance"      */
+/* record of the -stats stream (standard output by default); one    */
+/* that cannot be read or parsed gives an "error" record.           */
+/********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
+using namespace CMSat;
+
+namespace CMSat {
+
+struct BatchState
+{
+    std::vector<std::string> files;
+    std::atomic<size_t> next{0};  /* index of the next formula to solve */
+
+    std::mutex lock;              /* guards the totals */
+    uint32_t solved = 0;
+    uint32_t errors = 0;
+    int64_t flips = 0;
+    double seconds = 0;           /* time spent searching, summed over the workers */
+};
+
+}
+
+static bool is_directory(const char* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+static void list_files(const char* path, std::vector<std::string>& files)
+{
+    if (is_directory(path)) {
+#ifndef _WIN32
+        DIR* dir = opendir(path);
+        if (dir == NULL) {
+            fprintf(stderr, "Cannot open directory %s\n", path);
+            exit(-1);
+        }
+        while (const struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.')
+                continue;
+            const std::string file = std::string(path) + "/" + entry->d_name;
+            if (!is_directory(file.c_str()))
+                files.push_back(file);
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+#else
+        fprintf(stderr, "-batch needs a list of files on Windows, not a directory\n");
+        exit(-1);
+#endif
+        return;
+    }
+
+    FILE* list = fopen(path, "r");
+    if (list == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        exit(-1);
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), list) != NULL) {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' '))
+            line[--n] = '\0';
+        if (n > 0)
+            files.push_back(line);
+    }
+    fclose(list);
+}
+
+int WalkSAT::batch_main()
+{
+    batch = new BatchState;
+    list_files(batch_path, batch->files);
+    if (batch->files.empty()) {
+        fprintf(stderr, "No formulas in %s\n", batch_path);
+        exit(-1);
+    }
+    quiet = true;
+    stats_open();
+
+    const int numworkers = std::min<size_t>(numthreads, batch->files.size());
+    std::vector<WalkSAT*> workers;
+    for (int t = 1; t < numworkers; t++) {
+        WalkSAT* w = new WalkSAT(*this);
+        w->worker_id = t;
+        workers.push_back(w);
+    }
+
+    const double start = wallTime();
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numworkers; t++)
+        threads.push_back(std::thread(&WalkSAT::batch_worker, workers[t - 1], (uint32_t)t));
+    batch_worker(0);
+    for (std::thread& t : threads)
+        t.join();
+    const double wall = wallTime() - start;
+
+    for (WalkSAT* w : workers) {
+        /* shared with this one */
+        w->batch = NULL;
+        w->stats = NULL;
+        w->numa = NULL;
+        delete w;
+    }
+
+    const size_t numfiles = batch->files.size();
+    printf("formulas = %zu, solved = %u, unreadable = %u\n", numfiles, batch->solved, batch->errors);
+    printf("total elapsed seconds = %f\n", wall);
+    printf("formulas per second = %f\n", numfiles / wall);
+    printf("total flips = %" BIGFORMAT "\n", batch->flips);
+    printf("average flips per second per thread = %f\n",
+           batch->seconds > 0 ? batch->flips / batch->seconds : 0);
+    const int solved = batch->solved;
+    delete batch;
+    batch = NULL;
+    return solved;
+}
+
+/* Solves formulas until the list is exhausted, reusing this walker's arenas */
+void WalkSAT::batch_worker(uint32_t thread)
+{
+    numa_pin_thread(thread);
+    for (;;) {
+        const size_t k = batch->next.fetch_add(1);
+        if (k >= batch->files.size())
+            break;
+        const char* file = batch->files[k].c_str();
+
+        cnfStream = fopen(file, "r");
+        if (cnfStream == NULL) {
+            stats_instance(file, "error", 0);
+            std::lock_guard<std::mutex> guard(batch->lock);
+            batch->errors++;
+            continue;
+        }
+        rng.seed(seed, 0);
+        const double parse_start = wallTime();
+        const bool ok = initprob();
+        fclose(cnfStream);
+        cnfStream = NULL;
+        if (!ok) {
+            stats_instance(file, "error", 0);
+            std::lock_guard<std::mutex> guard(batch->lock);
+            batch->errors++;
+            continue;
+        }
+        alloc_walker();
+        initialize_statistics();
+        const double search_start = wallTime();
+        deadline = time_limit > 0 ? search_start + time_limit : 0;
+        run_tries();
+        expertime = wallTime() - search_start;
+        stats_instance(file, found_solution ? "sat" : "unknown", search_start - parse_start);
+
+        std::lock_guard<std::mutex> guard(batch->lock);
+        batch->solved += found_solution > 0;
+        batch->flips += totalflip;
+        batch->seconds += expertime;
+    }
+}
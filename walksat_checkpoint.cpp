@@ -0,0 +1,250 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Checkpoint and resume, with -checkpoint FILE and -resume FILE.   */
+/*                                                                  */
+/* A checkpoint holds everything the search depends on: the         */
+/* assignment, the order of the literals in the clauses (flipvar()  */
+/* moves true literals first) and of the false clause list, the     */
+/* random stream, the flip and try counters and every statistics    */
+/* accumulator.  The counters derived from the assignment are       */
+/* rebuilt by init_counters() on resume, after which the search     */
+/* continues exactly as it would have, flip for flip.               */
+/*                                                                  */
+/* Checkpoints are taken from poll(): every -checkpointsec seconds, */
+/* on SIGUSR1, and when a stop signal ends the search.              */
+/* The file is written next to FILE and renamed over it, so a kill  */
+/* during the write leaves the previous checkpoint intact.  Resume  */
+/* with the same options; the formula is checked against the one   */
+/* the checkpoint was taken of.                                     */
+/********************************************************************/
+
+#include <csignal>
+#include <cstring>
+#include <string>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+#define CHECKPOINT_VERSION 1
+static const char CHECKPOINT_MAGIC[8] = {'\x7f', 'W', 'S', 'C', 'K', 'P', 'T', '\0'};
+
+/* set by SIGUSR1, acted upon by the next poll() */
+static volatile sig_atomic_t checkpoint_requested = 0;
+
+static void on_checkpoint_signal(int)
+{
+    checkpoint_requested = 1;
+}
+
+/* Reads or writes n values at p */
+template<class T>
+static bool checkpoint_io(FILE* f, T* p, size_t n, bool save)
+{
+    return save ? fwrite(p, sizeof(T), n, f) == n : fread(p, sizeof(T), n, f) == n;
+}
+
+/* Independent of the literal order within clauses, which the search changes */
+uint64_t WalkSAT::formula_fingerprint() const
+{
+    uint64_t h = 0;
+    for (uint32_t i = 0; i < numclauses; i++) {
+        uint64_t c = 0;
+        for (uint32_t j = 0; j < clsize[i]; j++) {
+            uint64_t x = clause[i][j].toInt();
+            c += splitmix64(x);
+        }
+        uint64_t x = c ^ i;
+        h ^= splitmix64(x);
+    }
+    return h;
+}
+
+void WalkSAT::checkpoint_setup()
+{
+    if (checkpoint_path == NULL)
+        return;
+#ifdef SIGUSR1
+    signal(SIGUSR1, on_checkpoint_signal);
+#endif
+    next_checkpoint = checkpoint_every > 0 ? wallTime() + checkpoint_every : 0;
+}
+
+/* Everything but the header, in one order for both directions */
+bool WalkSAT::checkpoint_state(FILE* f, bool save, double& seconds)
+{
+    bool ok = checkpoint_io(f, &rng, 1, save)
+              && checkpoint_io(f, &numflip, 1, save)
+              && checkpoint_io(f, &numtry, 1, save)
+              && checkpoint_io(f, &next_poll, 1, save)
+              && checkpoint_io(f, &numfalse, 1, save)
+              && checkpoint_io(f, assigns, numvars, save)
+              && checkpoint_io(f, &lowbad, 1, save)
+              && checkpoint_io(f, &sample_size, 1, save)
+              && checkpoint_io(f, &sumfalse, 1, save)
+              && checkpoint_io(f, &sumfalse_squared, 1, save)
+              && checkpoint_io(f, &undo_count, 1, save)
+              && checkpoint_io(f, &undo_pos, 1, save)
+              && checkpoint_io(f, undo_ring, undo_age, save)
+              && checkpoint_io(f, &totalflip, 1, save)
+              && checkpoint_io(f, &totalsuccessflip, 1, save)
+              && checkpoint_io(f, &found_solution, 1, save)
+              && checkpoint_io(f, &x, 1, save)
+              && checkpoint_io(f, &integer_sum_x, 1, save)
+              && checkpoint_io(f, &sum_x, 1, save)
+              && checkpoint_io(f, &mean_x, 1, save)
+              && checkpoint_io(f, &r, 1, save)
+              && checkpoint_io(f, &sum_r, 1, save)
+              && checkpoint_io(f, &mean_r, 1, save)
+              && checkpoint_io(f, &sum_avgfalse, 1, save)
+              && checkpoint_io(f, &sum_std_dev_avgfalse, 1, save)
+              && checkpoint_io(f, &number_sampled_runs, 1, save)
+              && checkpoint_io(f, &suc_sum_avgfalse, 1, save)
+              && checkpoint_io(f, &suc_sum_std_dev_avgfalse, 1, save)
+              && checkpoint_io(f, &suc_number_sampled_runs, 1, save)
+              && checkpoint_io(f, &nonsuc_sum_avgfalse, 1, save)
+              && checkpoint_io(f, &nonsuc_sum_std_dev_avgfalse, 1, save)
+              && checkpoint_io(f, &nonsuc_number_sampled_runs, 1, save)
+              && checkpoint_io(f, &histtotal, 1, save)
+              && checkpoint_io(f, histcount, HISTMAX, save)
+              && checkpoint_io(f, histflips, HISTMAX, save)
+              && checkpoint_io(f, histsecs, HISTMAX, save)
+              && checkpoint_io(f, &hist_censored, 1, save)
+              && checkpoint_io(f, &hist_censored_flips, 1, save)
+              && checkpoint_io(f, &occ_visited, 1, save)
+              && checkpoint_io(f, &clause_rescans, 1, save)
+              && checkpoint_io(f, &seconds, 1, save)
+              && checkpoint_io(f, &best_numfalse, 1, save)
+              && checkpoint_io(f, &best_pending, 1, save)
+              && checkpoint_io(f, &best_trail_len, 1, save)
+              && best_trail_len <= numvars
+              && checkpoint_io(f, best_trail, best_trail_len, save)
+              && checkpoint_io(f, best_assigns, numvars, save)
+              && (solution == NULL || checkpoint_io(f, solution, numvars, save))
+              && (init_order == NULL || checkpoint_io(f, init_order, numvars, save))
+              && numfalse <= numclauses
+              && checkpoint_io(f, false_cls, numfalse, save);
+    for (uint32_t i = 0; i < numclauses && ok; i++)
+        ok = checkpoint_io(f, clause[i], clsize[i], save);
+    return ok;
+}
+
+void WalkSAT::checkpoint_write()
+{
+    const std::string tmp = std::string(checkpoint_path) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write checkpoint %s\n", tmp.c_str());
+        return;
+    }
+
+    /* CPU time of the search so far, that of a resumed run added to it */
+    double seconds = resumed_seconds + cpuTime();
+    uint32_t head[4] = {CHECKPOINT_VERSION, numvars, numclauses, numliterals};
+    uint64_t fingerprint = formula_fingerprint();
+    bool ok = fwrite(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), 1, f) == 1
+              && checkpoint_io(f, head, 4, true)
+              && checkpoint_io(f, &fingerprint, 1, true)
+              && checkpoint_io(f, &seed, 1, true)
+              && checkpoint_state(f, true, seconds);
+
+    if (fclose(f) != 0 || !ok || rename(tmp.c_str(), checkpoint_path) != 0) {
+        fprintf(stderr, "Cannot write checkpoint %s\n", checkpoint_path);
+        remove(tmp.c_str());
+        return;
+    }
+    if (!quiet) {
+        printf("checkpoint written to %s at try %i, flip %" BIGFORMAT "\n", checkpoint_path,
+               numtry, numflip);
+        fflush(stdout);
+    }
+}
+
+/* Replaces the state of a fresh run by that of the checkpoint; the */
+/* next run_tries() continues the try that was interrupted          */
+void WalkSAT::checkpoint_read()
+{
+    FILE* f = fopen(resume_path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open checkpoint %s\n", resume_path);
+        exit(-1);
+    }
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    uint32_t head[4];
+    uint64_t fingerprint;
+    unsigned int saved_seed;
+    if (fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0
+        || !checkpoint_io(f, head, 4, false) || head[0] != CHECKPOINT_VERSION
+        || !checkpoint_io(f, &fingerprint, 1, false) || !checkpoint_io(f, &saved_seed, 1, false)) {
+        fprintf(stderr, "%s is not a walksat checkpoint\n", resume_path);
+        exit(-1);
+    }
+    if (head[1] != numvars || head[2] != numclauses || head[3] != numliterals
+        || fingerprint != formula_fingerprint()) {
+        fprintf(stderr, "Checkpoint %s is of another formula\n", resume_path);
+        exit(-1);
+    }
+    if (saved_seed != seed)
+        fprintf(stderr, "Checkpoint was taken with seed %u, continuing its random stream\n",
+                saved_seed);
+    seed = saved_seed;
+    if (!checkpoint_state(f, false, resumed_seconds)) {
+        fprintf(stderr, "Checkpoint %s is truncated or damaged\n", resume_path);
+        exit(-1);
+    }
+    fclose(f);
+
+    /* rebuild the counters, then put the false clauses back in their order */
+    const uint32_t saved_numfalse = numfalse;
+    std::vector<uint32_t> saved_false(false_cls, false_cls + numfalse);
+    init_counters();
+    if (numfalse != saved_numfalse) {
+        fprintf(stderr, "Checkpoint %s does not match its assignment\n", resume_path);
+        exit(-1);
+    }
+    for (uint32_t i = 0; i < numfalse; i++) {
+        false_cls[i] = saved_false[i];
+        wherefalse[false_cls[i]] = i;
+    }
+
+    resuming = numtry > 0;
+    if (!quiet)
+        printf("resumed from %s at try %i, flip %" BIGFORMAT "\n", resume_path, numtry, numflip);
+}
+
+/* From poll(): periodic and requested checkpoints, and one before a */
+/* stop signal ends the search                                       */
+void WalkSAT::checkpoint_poll()
+{
+    const bool periodic = next_checkpoint > 0 && wallTime() >= next_checkpoint;
+    if (!periodic && !checkpoint_requested && !stop_signal)
+        return;
+    checkpoint_requested = 0;
+    checkpoint_write();
+    if (periodic)
+        next_checkpoint = wallTime() + checkpoint_every;
+    if (stop_signal)
+        printf("resume with -resume %s\n", checkpoint_path);
+}
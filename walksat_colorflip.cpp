@@ -0,0 +1,384 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Parallel flipping within one walk, for very large formulas.      */
+/*                                                                  */
+/* Variables are greedily colored so that two variables of the same */
+/* color never occur in a common clause.  Flipping such variables   */
+/* touches disjoint sets of clauses: numtruelit[], the clause       */
+/* literal order and the assigns[] read during the flip are private */
+/* to the thread doing it.  Only breakcount[] of a third variable   */
+/* can be shared, so it is updated and read atomically, and changes */
+/* to the false clause list are collected per thread and merged by  */
+/* the leader after each round.                                     */
+/*                                                                  */
+/* A round: the leader picks a var with the usual heuristic and its */
+/* color becomes the color of the round.  Every thread then draws   */
+/* false clauses with its own random stream, picks a var in each    */
+/* the same way and flips it at once if it has that color and no    */
+/* other thread took it, until it has flipped its share.  A clause  */
+/* has at most one var of a color, so the false list of the start   */
+/* of the round stays valid to draw from.  The merge replays the    */
+/* flips one by one for the statistics; they commute, so numfalse   */
+/* after each is exact for that order.                              */
+/********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+#define FLIPS_PER_THREAD 64  /* most flips of a thread in one round */
+#define DRAWS_PER_FLIP 16    /* clauses drawn per flip, times the number of colors */
+#define ROUND_SHARE 8        /* a round flips at most numfalse / (numcolors * this) */
+
+namespace CMSat {
+
+/* Sense-free spin barrier, yields when the wait gets long */
+class SpinBarrier
+{
+public:
+    explicit SpinBarrier(uint32_t _n) : n(_n)
+    {
+    }
+
+    void wait()
+    {
+        const uint32_t g = gen.load(std::memory_order_acquire);
+        if (count.fetch_add(1, std::memory_order_acq_rel) + 1 == n) {
+            count.store(0, std::memory_order_relaxed);
+            gen.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        uint32_t spins = 0;
+        while (gen.load(std::memory_order_acquire) == g) {
+            if (++spins > 1000)
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    const uint32_t n;
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> gen{0};
+};
+
+/* What one thread did in a round, on its own cache lines */
+struct alignas(64) ColorFlipThread
+{
+    Rng rng;                            /* thread 0 uses the walker's */
+    uint32_t quota = 0;                 /* most flips this round */
+    std::vector<uint32_t> flipped;      /* in the order flipped */
+    std::vector<int32_t> delta;         /* change of numfalse by each */
+    std::vector<uint32_t> became_false; /* merged by the leader */
+    std::vector<uint32_t> became_true;
+    std::vector<uint32_t> best;         /* ties of colorflip_pick() */
+};
+
+struct ColorFlipState
+{
+    explicit ColorFlipState(uint32_t numthreads) : barrier(numthreads), thread(numthreads)
+    {
+    }
+
+    SpinBarrier barrier;
+    std::vector<std::thread> threads;
+    bool quit = false;
+
+    std::vector<ColorFlipThread> thread;
+    std::vector<uint32_t> picked; /* round a var was taken in, avoids flipping it twice */
+    uint32_t round = 0;
+    uint32_t color = 0;           /* of the vars flipped this round */
+};
+
+}
+
+/* Greedy coloring of the variable interaction graph, in var order */
+void WalkSAT::color_vars()
+{
+    varcolor = formula_mem->alloc<uint32_t>(numvars, "variable colors");
+    std::vector<uint32_t> used; /* used[c] == v+1 if a neighbour of v has color c */
+    numcolors = 0;
+
+    for (uint32_t v = 0; v < numvars; v++) {
+        for (uint32_t sign = 0; sign < 2; sign++) {
+            const Lit lit(v, sign);
+            for (uint32_t i = 0; i < numoccurrence[lit.toInt()]; i++) {
+                const uint32_t cli = occurrence[lit.toInt()][i];
+                for (uint32_t j = 0; j < clsize[cli]; j++) {
+                    const uint32_t other = clause[cli][j].var();
+                    if (other < v)
+                        used[varcolor[other]] = v + 1;
+                }
+            }
+        }
+        uint32_t c = 0;
+        while (c < numcolors && used[c] == v + 1)
+            c++;
+        if (c == numcolors) {
+            numcolors++;
+            used.push_back(0);
+        }
+        varcolor[v] = c;
+    }
+    printf("variable interaction graph colored with %u colors\n", numcolors);
+}
+
+/* flipvar() for a var whose clauses no other thread is touching */
+void WalkSAT::flipvar_concurrent(uint32_t toflip, uint32_t thread)
+{
+    std::vector<uint32_t>& became_false = cf->thread[thread].became_false;
+    std::vector<uint32_t>& became_true = cf->thread[thread].became_true;
+    Lit toenforce;
+
+    if (assigns[toflip] == l_True)
+        toenforce = Lit(toflip, true);
+    else
+        toenforce = Lit(toflip, false);
+    assigns[toflip] = assigns[toflip] ^ true;
+
+    //True made into False
+    uint32_t numocc = numoccurrence[(~toenforce).toInt()];
+    const uint32_t* occptr = occurrence[(~toenforce).toInt()];
+    for (uint32_t i = 0; i < numocc; i++) {
+        const uint32_t cli = occptr[i];
+        assert(numtruelit[cli] > 0);
+        numtruelit[cli]--;
+        if (numtruelit[cli] == 0) {
+            became_false.push_back(cli);
+            __atomic_fetch_sub(&breakcount[toflip], 1, __ATOMIC_RELAXED);
+        } else if (numtruelit[cli] == 1) {
+            /* Find the lit that makes it true, inc its breakcount, swap it first */
+            Lit* litptr = clause[cli];
+            while (value(*litptr) != l_True)
+                litptr++;
+            __atomic_fetch_add(&breakcount[litptr->var()], 1, __ATOMIC_RELAXED);
+            if (litptr != clause[cli]) {
+                Lit temp = clause[cli][0];
+                clause[cli][0] = *litptr;
+                *litptr = temp;
+            }
+        }
+    }
+
+    numocc = numoccurrence[toenforce.toInt()];
+    occptr = occurrence[toenforce.toInt()];
+    for (uint32_t i = 0; i < numocc; i++) {
+        const uint32_t cli = occptr[i];
+        numtruelit[cli]++;
+        if (numtruelit[cli] == 1) {
+            became_true.push_back(cli);
+            __atomic_fetch_add(&breakcount[toflip], 1, __ATOMIC_RELAXED);
+        } else if (numtruelit[cli] == 2) {
+            /* Find the other lit that makes it true and dec its breakcount */
+            const Lit* litptr = clause[cli];
+            while (value(*litptr) != l_True || litptr->var() == toflip)
+                litptr++;
+            __atomic_fetch_sub(&breakcount[litptr->var()], 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* pickbest() for a thread: its own random stream and ties, and the  */
+/* breakcounts read atomically as other threads may be updating them */
+uint32_t WalkSAT::colorflip_pick(uint32_t tofix, uint32_t thread)
+{
+    ColorFlipThread& me = cf->thread[thread];
+    Rng& r = thread == 0 ? rng : me.rng;
+    const uint32_t clausesize = clsize[tofix];
+    const Lit* lits = clause[tofix];
+    uint32_t numbest = 0;
+    uint32_t bestvalue = std::numeric_limits<uint32_t>::max();
+
+    for (uint32_t i = 0; i < clausesize; i++) {
+        const uint32_t var = lits[i].var();
+        const uint32_t numbreak = __atomic_load_n(&breakcount[var], __ATOMIC_RELAXED);
+        if (numbreak <= bestvalue) {
+            if (numbreak < bestvalue)
+                numbest = 0;
+            bestvalue = numbreak;
+            me.best[numbest++] = var;
+        }
+    }
+
+    if ((bestvalue > 0) && (r.below(denominator) < (uint32_t)numerator))
+        return lits[r.below(clausesize)].var();
+
+    return me.best[r.below(numbest)];
+}
+
+/* Flips of one thread in a round; the leader has flipped its pick already */
+void WalkSAT::colorflip_work(uint32_t thread)
+{
+    ColorFlipThread& me = cf->thread[thread];
+    Rng& r = thread == 0 ? rng : me.rng;
+    const uint32_t maxdraws = me.quota * numcolors * DRAWS_PER_FLIP;
+
+    for (uint32_t draw = 0; draw < maxdraws && me.flipped.size() < me.quota; draw++) {
+        const uint32_t tofix = false_cls[r.below(numfalse)];
+        /* cheap test first: the clause needs a var of the round's color */
+        uint32_t i = 0;
+        while (i < clsize[tofix] && varcolor[clause[tofix][i].var()] != cf->color)
+            i++;
+        if (i == clsize[tofix])
+            continue;
+
+        const uint32_t var = colorflip_pick(tofix, thread);
+        if (varcolor[var] != cf->color
+            || __atomic_exchange_n(&cf->picked[var], cf->round, __ATOMIC_RELAXED) == cf->round)
+            continue;
+        colorflip_flip(var, thread);
+    }
+}
+
+/* flipvar_concurrent(), logging the flip for the merge */
+void WalkSAT::colorflip_flip(uint32_t var, uint32_t thread)
+{
+    ColorFlipThread& me = cf->thread[thread];
+    const size_t numbroken = me.became_false.size();
+    const size_t numfixed = me.became_true.size();
+    flipvar_concurrent(var, thread);
+    me.flipped.push_back(var);
+    me.delta.push_back((int32_t)(me.became_false.size() - numbroken)
+                       - (int32_t)(me.became_true.size() - numfixed));
+}
+
+void WalkSAT::colorflip_worker(uint32_t thread)
+{
+    numa_pin_thread(thread);
+    while (true) {
+        cf->barrier.wait();
+        if (cf->quit)
+            return;
+        colorflip_work(thread);
+        cf->barrier.wait();
+    }
+}
+
+void WalkSAT::colorflip_start()
+{
+    color_vars();
+    cf = new ColorFlipState(numthreads);
+    cf->picked.resize(numvars);
+    for (uint32_t t = 0; t < (uint32_t)numthreads; t++) {
+        /* streams as for -coop workers, see coop_main() */
+        cf->thread[t].rng.seed(seed, t);
+        cf->thread[t].best.resize(longestclause);
+    }
+    for (uint32_t t = 1; t < (uint32_t)numthreads; t++)
+        cf->threads.push_back(std::thread(&WalkSAT::colorflip_worker, this, t));
+}
+
+void WalkSAT::colorflip_stop()
+{
+    cf->quit = true;
+    cf->barrier.wait();
+    for (std::thread& t : cf->threads)
+        t.join();
+    delete cf;
+    cf = NULL;
+}
+
+/* One try, same stopping rule as flip_loop() */
+void WalkSAT::colorflip_loop()
+{
+    while ((numfalse > 0) && (numflip < cutoff)) {
+        /* a round only flips vars of one color, and the good moves of that */
+        /* color run out while it lasts; keep it short against numfalse     */
+        uint64_t left = std::max<uint64_t>(1, numfalse / (numcolors * ROUND_SHARE));
+        left = std::min<uint64_t>(left, FLIPS_PER_THREAD * numthreads);
+        left = std::min<uint64_t>(left, cutoff - numflip);
+        for (uint32_t t = 0; t < (uint32_t)numthreads; t++)
+            cf->thread[t].quota = left / numthreads + (t < left % numthreads);
+
+        /* the leader's pick sets the color, so every round flips something */
+        cf->round++;
+        const uint32_t first = pickvar();
+        cf->color = varcolor[first];
+        cf->picked[first] = cf->round;
+        colorflip_flip(first, 0);
+
+        cf->barrier.wait();
+        colorflip_work(0);
+        cf->barrier.wait();
+
+        /* replay the flips for the statistics; the try ends at a solution */
+        const uint32_t startfalse = numfalse;
+        uint32_t solvedby = numthreads;
+        size_t solvedat = 0;
+        for (uint32_t t = 0; t < (uint32_t)numthreads && solvedby == (uint32_t)numthreads; t++) {
+            const ColorFlipThread& th = cf->thread[t];
+            for (size_t i = 0; i < th.delta.size(); i++) {
+                numfalse += th.delta[i];
+                numflip++;
+                if (!lean) {
+                    update_undo(th.flipped[i]);
+                    update_statistics_end_flip();
+                }
+                if (numfalse == 0) {
+                    solvedby = t;
+                    solvedat = i + 1;
+                    break;
+                }
+            }
+        }
+
+        /* merge the false list changes; each clause appears at most once */
+        numfalse = startfalse;
+        for (uint32_t t = 0; t < (uint32_t)numthreads; t++) {
+            ColorFlipThread& th = cf->thread[t];
+            for (uint32_t cli : th.became_true) {
+                numfalse--;
+                false_cls[wherefalse[cli]] = false_cls[numfalse];
+                wherefalse[false_cls[numfalse]] = wherefalse[cli];
+            }
+            for (uint32_t cli : th.became_false) {
+                false_cls[numfalse] = cli;
+                wherefalse[cli] = numfalse;
+                numfalse++;
+            }
+            th.became_true.clear();
+            th.became_false.clear();
+        }
+
+        /* flips after the one that solved it are taken back */
+        for (uint32_t t = solvedby; t < (uint32_t)numthreads; t++) {
+            ColorFlipThread& th = cf->thread[t];
+            const size_t from = t == solvedby ? solvedat : 0;
+            replay_flips(th.flipped.data() + from, th.flipped.size() - from);
+        }
+        for (uint32_t t = 0; t < (uint32_t)numthreads; t++) {
+            cf->thread[t].flipped.clear();
+            cf->thread[t].delta.clear();
+        }
+
+        if (numflip >= next_poll && poll())
+            break;
+    }
+}
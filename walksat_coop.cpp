@@ -0,0 +1,290 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Cooperative search: several workers, each an independent walk    */
+/* with its own counters, share the read-only clause database and a */
+/* small pool of elite assignments.                                 */
+/*                                                                  */
+/* Every POLL_INTERVAL flips and at the end of every try a worker   */
+/* offers its best assignment so far to the pool, if it improved    */
+/* since the last offer and has fewer false clauses than the worst  */
+/* elite, and checks whether another worker has found a solution.   */
+/* With -lean the best is only known at the ends of the tries.      */
+/* Every other try of a worker starts from a majority vote of up to */
+/* three random elites with a fraction of the vars re-randomized    */
+/* instead of from a random assignment.                             */
+/*                                                                  */
+/* Elite slots are seqlocks of atomic words: a writer that finds    */
+/* the slot busy gives up, a reader that sees it change skips it,   */
+/* so no worker ever waits for another.                             */
+/********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+#define ELITE_PARENTS 3 /* elites combined into one starting assignment */
+
+namespace CMSat {
+
+struct EliteSlot
+{
+    std::atomic<uint32_t> seq{0}; /* odd while being written */
+    std::atomic<uint32_t> score{std::numeric_limits<uint32_t>::max()}; /* max when empty */
+    std::unique_ptr<std::atomic<uint64_t>[]> bits;
+};
+
+struct CoopState
+{
+    CoopState(uint32_t numelites, uint32_t numwords)
+        : slots(numelites), numwords(numwords)
+    {
+        for (EliteSlot& slot : slots) {
+            slot.bits.reset(new std::atomic<uint64_t>[numwords]);
+            for (uint32_t i = 0; i < numwords; i++)
+                slot.bits[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> nexttry{0};  /* tries handed out, over all workers */
+    std::atomic<int> winner{-1};  /* worker that found a solution */
+    std::vector<EliteSlot> slots;
+    const uint32_t numwords;
+};
+
+}
+
+/* Replaces the try loop of main(): numthreads workers share the tries, */
+/* the first one to satisfy all clauses stops the others.              */
+void WalkSAT::coop_main()
+{
+    const uint32_t numwords = (numvars + 63) / 64;
+    coop = new CoopState(numelites, numwords);
+    shared_clauses = true;
+    elite_buf = walker_mem->alloc<uint64_t>(ELITE_PARENTS * (size_t)numwords, "elite scratch");
+
+    std::vector<WalkSAT*> workers;
+    workers.push_back(this);
+    for (int t = 1; t < numthreads; t++) {
+        WalkSAT* w = new WalkSAT(*this);
+        w->worker_id = t;
+        w->rng.seed(seed, t);
+        w->quiet = true;
+        w->perfstate = NULL;  /* counters and records follow the main thread only */
+        w->stats = NULL;
+        w->trace = NULL;
+        /* allocated by the worker itself, see coop_search() */
+        w->walker_mem = NULL;
+        w->formula_mem = NULL;
+        workers.push_back(w);
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numthreads; t++)
+        threads.push_back(std::thread(&WalkSAT::coop_search, workers[t]));
+    coop_search();
+    for (std::thread& t : threads)
+        t.join();
+
+    /* fold the helpers' statistics into this one */
+    const int winner = coop->winner.load();
+    printf("\nworker     tries     flips    lowbad\n");
+    for (int t = 0; t < numthreads; t++) {
+        WalkSAT* w = workers[t];
+        printf("%6i %9i %9" BIGFORMAT, t, w->numtry, w->totalflip);
+        if (w->numtry > 0)
+            printf(" %9i%s\n", w->lowbad, t == winner ? "  solution" : "");
+        else
+            printf(" %9s\n", "-");
+        if (t == 0)
+            continue;
+        numtry += w->numtry;
+        totalflip += w->totalflip;
+        sum_avgfalse += w->sum_avgfalse;
+        sum_std_dev_avgfalse += w->sum_std_dev_avgfalse;
+        number_sampled_runs += w->number_sampled_runs;
+        suc_sum_avgfalse += w->suc_sum_avgfalse;
+        suc_sum_std_dev_avgfalse += w->suc_sum_std_dev_avgfalse;
+        suc_number_sampled_runs += w->suc_number_sampled_runs;
+        nonsuc_sum_avgfalse += w->nonsuc_sum_avgfalse;
+        nonsuc_sum_std_dev_avgfalse += w->nonsuc_sum_std_dev_avgfalse;
+        nonsuc_number_sampled_runs += w->nonsuc_number_sampled_runs;
+        histtotal += w->histtotal;
+        for (int b = 0; b < HISTMAX; b++) {
+            histcount[b] += w->histcount[b];
+            histflips[b] += w->histflips[b];
+            histsecs[b] = std::max(histsecs[b], w->histsecs[b]);
+        }
+        hist_censored += w->hist_censored;
+        hist_censored_flips += w->hist_censored_flips;
+    }
+
+    if (winner >= 0) {
+        WalkSAT* w = workers[winner];
+        if (w != this) {
+            memcpy(assigns, w->assigns, sizeof(lbool) * numvars);
+            numfalse = countunsat();
+        }
+        found_solution = 1;
+        totalsuccessflip = w->numflip;
+        /* all workers flipped until the winner was found */
+        mean_x = (double)totalflip;
+        mean_r = numtry;
+    }
+
+    for (int t = 1; t < numthreads; t++) {
+        workers[t]->coop = NULL;
+        workers[t]->numa = NULL;
+        delete workers[t];
+    }
+}
+
+/* Try loop of one worker */
+void WalkSAT::coop_search()
+{
+    if (worker_id > 0) {
+        /* first touch from the worker's thread puts its state on its node */
+        numa_attach_formula(numa_pin_thread(worker_id));
+        alloc_walker();
+        elite_buf = walker_mem->alloc<uint64_t>(ELITE_PARENTS * (size_t)coop->numwords, "elite scratch");
+    }
+
+    while (!coop->stop.load(std::memory_order_relaxed) && !stopped) {
+        if (coop->nexttry.fetch_add(1) >= numrun)
+            break;
+        numtry++;
+        init();
+        numflip = 0;
+        update_statistics_start_try();
+        flip_loop();
+        update_and_print_statistics_end_try();
+        coop_offer();
+
+        if (numfalse == 0) {
+            int nowinner = -1;
+            coop->winner.compare_exchange_strong(nowinner, worker_id);
+            coop->stop.store(true);
+            break;
+        }
+    }
+}
+
+/* Offer the best assignment to the pool, returns true if the search is over */
+bool WalkSAT::coop_poll()
+{
+    coop_offer();
+    return coop->stop.load(std::memory_order_relaxed);
+}
+
+/* Publishes the best assignment if it improved since the last offer */
+void WalkSAT::coop_offer()
+{
+    if (best_numfalse >= coop_offered)
+        return;
+    uint32_t worst = 0;
+    for (const EliteSlot& slot : coop->slots)
+        worst = std::max(worst, slot.score.load(std::memory_order_relaxed));
+    if (best_numfalse < worst) {
+        save_best();
+        if (!coop_publish())
+            return;  /* the slot was busy, offer again at the next poll */
+    }
+    coop_offered = best_numfalse;
+}
+
+/* Replace the worst elite by the best assignment; false if it is being written */
+bool WalkSAT::coop_publish()
+{
+    EliteSlot* worst = NULL;
+    for (EliteSlot& slot : coop->slots) {
+        if (worst == NULL
+            || slot.score.load(std::memory_order_relaxed) > worst->score.load(std::memory_order_relaxed))
+            worst = &slot;
+    }
+
+    uint32_t seq = worst->seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !worst->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire))
+        return false;
+    if (best_numfalse < worst->score.load(std::memory_order_relaxed)) {
+        for (uint32_t i = 0; i < coop->numwords; i++) {
+            uint64_t word = 0;
+            const uint32_t end = std::min(numvars, (i + 1) * 64);
+            for (uint32_t v = i * 64; v < end; v++)
+                word |= (uint64_t)(best_assigns[v] == l_True) << (v - i * 64);
+            worst->bits[i].store(word, std::memory_order_relaxed);
+        }
+        worst->score.store(best_numfalse, std::memory_order_relaxed);
+    }
+    worst->seq.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+/* Starting assignment from the elite pool, false if it is still empty */
+bool WalkSAT::coop_seed_assignment()
+{
+    const uint32_t numwords = coop->numwords;
+    const uint32_t numslots = coop->slots.size();
+    uint32_t numparents = 0;
+
+    for (uint32_t k = 0; k < ELITE_PARENTS; k++) {
+        EliteSlot& slot = coop->slots[rng.below(numslots)];
+        const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        if ((seq & 1) || slot.score.load(std::memory_order_relaxed) == std::numeric_limits<uint32_t>::max())
+            continue;
+        uint64_t* dst = elite_buf + (size_t)numparents * numwords;
+        for (uint32_t i = 0; i < numwords; i++)
+            dst[i] = slot.bits[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == seq)
+            numparents++;
+    }
+    if (numparents == 0)
+        return false;
+
+    const uint32_t noise = (uint32_t)(elite_noise * denominator);
+    for (uint32_t v = 0; v < numvars; v++) {
+        const uint32_t i = v / 64;
+        const uint32_t b = v % 64;
+        uint32_t ones = 0;
+        for (uint32_t k = 0; k < numparents; k++)
+            ones += (elite_buf[(size_t)k * numwords + i] >> b) & 1;
+
+        bool value;
+        if (2 * ones == numparents || rng.below(denominator) < noise)
+            value = rng.coin();  /* parents disagree evenly, or noise */
+        else
+            value = 2 * ones > numparents;
+        assigns[v] = value ? l_True : l_False;
+    }
+    return true;
+}
@@ -0,0 +1,403 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Solver daemon on a unix socket, with -daemon PATH.               */
+/*                                                                  */
+/* A client connects, sends one request line and, unless it names a */
+/* file, the formula itself, then shuts down its writing side:      */
+/*   solve [seed N] [cutoff N] [tries N] [numsol N] [seconds S]     */
+/*         [file PATH]                                              */
+/* Omitted values are those of the daemon's command line.  The      */
+/* formula is a cnf or a binary formula (see -savebinary).  The     */
+/* reply is one "instance" record in JSON, as -batch writes, and    */
+/* for a solution a line "v lit lit ... 0".                         */
+/*                                                                  */
+/* -threads N workers serve the connections.  Parsed formulas stay  */
+/* in an LRU cache of -cachemb MB, keyed by file name, size and     */
+/* modification time, or by a hash of the formula text, so a repeat */
+/* request skips initprob().  Cached clause databases are shared by */
+/* the workers, read-only.                                          */
+/********************************************************************/
+
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+#include "walksat_output.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace CMSat;
+
+namespace CMSat {
+
+/* A parsed clause database, owned by the cache */
+struct CachedFormula
+{
+    Arena *mem = NULL;
+    Lit **clause;
+    uint32_t *clsize;
+    uint32_t **occurrence;
+    uint32_t *numoccurrence;
+    uint32_t numvars, numclauses, numliterals, longestclause;
+
+    ~CachedFormula()
+    {
+        delete mem;
+    }
+};
+
+struct DaemonState
+{
+    std::mutex lock;                  /* guards everything below */
+    std::condition_variable ready;    /* a connection was queued */
+    std::deque<int> conns;            /* accepted, not yet served */
+
+    /* most recently used first; workers hold their formula through the shared_ptr */
+    typedef std::pair<std::string, std::shared_ptr<CachedFormula> > Entry;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t bytes = 0;
+    size_t limit;
+
+    /* request defaults, from the command line */
+    unsigned int seed;
+    int64_t cutoff;
+    int numrun;
+    int numsol;
+};
+
+}
+
+#ifndef _WIN32
+
+/* Looks key up, marking it most recently used */
+static std::shared_ptr<CachedFormula> cache_lookup(DaemonState* d, const std::string& key)
+{
+    std::lock_guard<std::mutex> guard(d->lock);
+    auto it = d->index.find(key);
+    if (it == d->index.end())
+        return NULL;
+    d->lru.splice(d->lru.begin(), d->lru, it->second);
+    return it->second->second;
+}
+
+/* Adds f under key, evicting the least recently used formulas over the limit */
+static std::shared_ptr<CachedFormula> cache_insert(DaemonState* d, const std::string& key,
+                                                   std::shared_ptr<CachedFormula> f)
+{
+    std::lock_guard<std::mutex> guard(d->lock);
+    auto it = d->index.find(key);
+    if (it != d->index.end())
+        return it->second->second;  /* another worker loaded it meanwhile */
+    d->lru.push_front(DaemonState::Entry(key, f));
+    d->index[key] = d->lru.begin();
+    d->bytes += f->mem->mapped();
+    while (d->bytes > d->limit && d->lru.size() > 1) {
+        const DaemonState::Entry& old = d->lru.back();
+        d->bytes -= old.second->mem->mapped();
+        d->index.erase(old.first);
+        d->lru.pop_back();
+    }
+    return f;
+}
+
+/* FNV-1a, to recognize a formula sent again */
+static uint64_t hash_text(const std::string& text)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text)
+        h = (h ^ c) * 0x100000001b3ULL;
+    return h;
+}
+
+int WalkSAT::daemon_main()
+{
+    signal(SIGPIPE, SIG_IGN);  /* a client that hangs up must not kill the daemon */
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(daemon_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path %s is too long\n", daemon_path);
+        exit(-1);
+    }
+    strcpy(addr.sun_path, daemon_path);
+    unlink(daemon_path);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0
+        || listen(listener, 64) != 0) {
+        perror(daemon_path);
+        exit(-1);
+    }
+
+    quiet = true;
+    stats_open();
+    dstate = new DaemonState;
+    dstate->limit = (size_t)cache_mb * 1048576;
+    dstate->seed = seed;
+    dstate->cutoff = cutoff;
+    dstate->numrun = numrun;
+    dstate->numsol = numsol;
+
+    std::vector<WalkSAT*> workers;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numthreads; t++) {
+        WalkSAT* w = new WalkSAT(*this);
+        w->worker_id = t;
+        workers.push_back(w);
+        threads.push_back(std::thread(&WalkSAT::daemon_worker, w, (uint32_t)t));
+    }
+    printf("listening on %s\n", daemon_path);
+    fflush(stdout);
+
+    for (;;) {
+        const int conn = accept(listener, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror("accept");
+            break;
+        }
+        std::lock_guard<std::mutex> guard(dstate->lock);
+        dstate->conns.push_back(conn);
+        dstate->ready.notify_one();
+    }
+
+    /* only reached if the socket fails: let the workers drain the queue */
+    {
+        std::lock_guard<std::mutex> guard(dstate->lock);
+        dstate->conns.push_back(-1);
+        dstate->ready.notify_all();
+    }
+    for (std::thread& t : threads)
+        t.join();
+    for (WalkSAT* w : workers) {
+        w->dstate = NULL;
+        w->stats = NULL;
+        w->numa = NULL;
+        delete w;
+    }
+    close(listener);
+    unlink(daemon_path);
+    delete dstate;
+    dstate = NULL;
+    return -1;
+}
+
+void WalkSAT::daemon_worker(uint32_t thread)
+{
+    numa_pin_thread(thread);
+    for (;;) {
+        int conn;
+        {
+            std::unique_lock<std::mutex> guard(dstate->lock);
+            dstate->ready.wait(guard, [this]() { return !dstate->conns.empty(); });
+            conn = dstate->conns.front();
+            if (conn < 0)
+                return;  /* shutting down, leave the marker for the others */
+            dstate->conns.pop_front();
+        }
+        daemon_serve(conn);
+    }
+}
+
+/* Reads a formula into a new cache entry; NULL if it does not parse */
+CachedFormula* WalkSAT::daemon_load(FILE* stream)
+{
+    formula_mem = NULL;
+    cnfStream = stream;
+    const bool ok = initprob();
+    cnfStream = NULL;
+    CachedFormula* f = new CachedFormula;
+    f->mem = formula_mem;
+    formula_mem = NULL;
+    if (!ok) {
+        delete f;
+        return NULL;
+    }
+    f->clause = clause;
+    f->clsize = clsize;
+    f->occurrence = occurrence;
+    f->numoccurrence = numoccurrence;
+    f->numvars = numvars;
+    f->numclauses = numclauses;
+    f->numliterals = numliterals;
+    f->longestclause = longestclause;
+    return f;
+}
+
+
+void WalkSAT::daemon_serve(int conn)
+{
+    FILE* in = fdopen(conn, "r");
+    FILE* out = fdopen(dup(conn), "w");
+    if (in == NULL || out == NULL) {
+        if (in != NULL)
+            fclose(in);
+        else
+            close(conn);
+        if (out != NULL)
+            fclose(out);
+        return;
+    }
+
+    /* the request line */
+    seed = dstate->seed;
+    cutoff = dstate->cutoff;
+    numrun = dstate->numrun;
+    numsol = dstate->numsol;
+    double seconds = time_limit;
+    std::string file;
+    char* line = NULL;
+    size_t linesize = 0;
+    bool ok = getline(&line, &linesize, in) > 0 && strncmp(line, "solve", 5) == 0;
+    char* save;
+    for (char* tok = ok ? strtok_r(line + 5, " \t\r\n", &save) : NULL; tok != NULL && ok;
+         tok = strtok_r(NULL, " \t\r\n", &save)) {
+        const char* value = strtok_r(NULL, " \t\r\n", &save);
+        if (value == NULL)
+            ok = false;
+        else if (strcmp(tok, "seed") == 0)
+            seed = strtoul(value, NULL, 10);
+        else if (strcmp(tok, "cutoff") == 0)
+            cutoff = parse_flips(value);
+        else if (strcmp(tok, "tries") == 0)
+            numrun = atoi(value);
+        else if (strcmp(tok, "numsol") == 0)
+            numsol = std::max(1, atoi(value));
+        else if (strcmp(tok, "seconds") == 0)
+            seconds = atof(value);
+        else if (strcmp(tok, "file") == 0)
+            file = value;
+        else
+            ok = false;
+    }
+    free(line);
+    if (!ok) {
+        stats_instance("-", "error", 0, out);
+        fclose(out);
+        fclose(in);
+        return;
+    }
+
+    /* the formula, from the cache if possible */
+    const double parse_start = wallTime();
+    std::shared_ptr<CachedFormula> f;
+    std::string key;
+    if (!file.empty()) {
+        struct stat st;
+        if (stat(file.c_str(), &st) == 0) {
+            key = "file:" + file + ":" + std::to_string((long long)st.st_size) + ":"
+                  + std::to_string((long long)st.st_mtime);
+            f = cache_lookup(dstate, key);
+            FILE* stream = f == NULL ? fopen(file.c_str(), "rb") : NULL;
+            if (stream != NULL) {
+                f.reset(daemon_load(stream));
+                fclose(stream);
+            }
+        }
+    } else {
+        std::string text;
+        char buf[1 << 16];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+            text.append(buf, n);
+        key = "cnf:" + std::to_string((unsigned long long)hash_text(text)) + ":"
+              + std::to_string(text.size());
+        f = cache_lookup(dstate, key);
+        FILE* stream = f == NULL && !text.empty() ? fmemopen(&text[0], text.size(), "r") : NULL;
+        if (stream != NULL) {
+            f.reset(daemon_load(stream));
+            fclose(stream);
+        }
+    }
+    const char* label = file.empty() ? "-" : file.c_str();
+    if (f == NULL) {
+        stats_instance(label, "error", 0, out);
+        stats_instance(label, "error", 0);
+        fclose(out);
+        fclose(in);
+        return;
+    }
+    f = cache_insert(dstate, key, f);
+    const double parse_seconds = wallTime() - parse_start;
+
+    /* solve with this worker's own search state */
+    clause = f->clause;
+    clsize = f->clsize;
+    occurrence = f->occurrence;
+    numoccurrence = f->numoccurrence;
+    numvars = f->numvars;
+    numclauses = f->numclauses;
+    numliterals = f->numliterals;
+    longestclause = f->longestclause;
+    shared_clauses = true;
+    alloc_walker();
+    rng.seed(seed, 0);
+    initialize_statistics();
+    const double search_start = wallTime();
+    deadline = seconds > 0 ? search_start + seconds : 0;
+    run_tries();
+    deadline = 0;
+    expertime = wallTime() - search_start;
+
+    const char* status = found_solution ? "sat" : "unknown";
+    stats_instance(label, status, parse_seconds, out);
+    stats_instance(label, status, parse_seconds);
+    if (found_solution) {
+        OutputBuffer model(out);
+        write_model(model, MODEL_PACKED, false);
+    }
+    fclose(out);
+    fclose(in);
+    clause = NULL;
+    clsize = NULL;
+    occurrence = NULL;
+    numoccurrence = NULL;
+}
+
+#else
+
+int WalkSAT::daemon_main()
+{
+    fprintf(stderr, "-daemon needs unix sockets, not available on this system\n");
+    exit(-1);
+}
+
+#endif
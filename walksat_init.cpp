@@ -0,0 +1,225 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Starting assignments of the tries, chosen with -init:            */
+/*   random    every var by a coin flip                             */
+/*   polarity  every var to the sign it occurs with most often      */
+/*   greedy    vars in random order, each to the sign satisfying    */
+/*             more of the clauses still false                      */
+/*   unitprop  vars in random order set by a coin flip, with unit   */
+/*             propagation after each; conflicts are left for the   */
+/*             walk to repair                                       */
+/* In polarity and greedy, ties and an -initnoise fraction of the   */
+/* vars are set by a coin flip, so the tries still differ.          */
+/*                                                                  */
+/* numtruelit[] and wherefalse[] serve as per clause scratch here,  */
+/* init_counters() rebuilds them from the assignment afterwards.    */
+/********************************************************************/
+
+#include <algorithm>
+#include <utility>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+const char* WalkSAT::init_mode_name(InitMode mode)
+{
+    switch (mode) {
+        case INIT_RANDOM: return "random";
+        case INIT_POLARITY: return "polarity";
+        case INIT_GREEDY: return "greedy";
+        case INIT_UNITPROP: return "unitprop";
+    }
+    return "?";
+}
+
+/* true with probability init_noise, for the vars left to a coin flip */
+inline bool WalkSAT::init_noisy()
+{
+    return init_numerator > 0 && (int)rng.below(denominator) < init_numerator;
+}
+
+/* init_order[] becomes a random permutation of the vars */
+void WalkSAT::init_shuffle()
+{
+    for (uint32_t i = 0; i < numvars; i++)
+        init_order[i] = i;
+    for (uint32_t i = numvars; i > 1; i--)
+        std::swap(init_order[i - 1], init_order[rng.below(i)]);
+}
+
+void WalkSAT::init_polarity()
+{
+    for (uint32_t v = 0; v < numvars; v++) {
+        const uint32_t pos = numoccurrence[Lit(v, false).toInt()];
+        const uint32_t neg = numoccurrence[Lit(v, true).toInt()];
+        if (pos == neg || init_noisy())
+            assigns[v] = rng.coin() ? l_False : l_True;
+        else
+            assigns[v] = pos > neg ? l_True : l_False;
+    }
+}
+
+void WalkSAT::init_greedy()
+{
+    for (uint32_t i = 0; i < numclauses; i++)
+        numtruelit[i] = 0;
+    init_shuffle();
+
+    for (uint32_t i = 0; i < numvars; i++) {
+        const uint32_t v = init_order[i];
+        uint32_t gain[2] = {0, 0};
+        for (int sign = 0; sign < 2; sign++) {
+            const Lit lit(v, sign);
+            const uint32_t* occ = occurrence[lit.toInt()];
+            for (uint32_t j = 0; j < numoccurrence[lit.toInt()]; j++)
+                gain[sign] += numtruelit[occ[j]] == 0;
+        }
+
+        bool sign;
+        if (gain[0] == gain[1] || init_noisy())
+            sign = rng.coin();
+        else
+            sign = gain[1] > gain[0];
+        const Lit lit(v, sign);
+        assigns[v] = l_True ^ sign;
+        const uint32_t* occ = occurrence[lit.toInt()];
+        for (uint32_t j = 0; j < numoccurrence[lit.toInt()]; j++)
+            numtruelit[occ[j]] = 1;
+    }
+}
+
+/* Makes lit true unless its var is set, and queues it for propagation */
+inline void WalkSAT::init_enqueue(Lit lit, uint32_t& qtail)
+{
+    if (assigns[lit.var()] != l_Undef)
+        return;
+    assigns[lit.var()] = l_True ^ lit.sign();
+    init_queue[qtail++] = lit.var();
+}
+
+/* numtruelit[c] counts the true and wherefalse[c] the false literals */
+/* of clause c among the vars set so far                              */
+void WalkSAT::init_unitprop()
+{
+    for (uint32_t i = 0; i < numclauses; i++) {
+        numtruelit[i] = 0;
+        wherefalse[i] = 0;
+    }
+    for (uint32_t v = 0; v < numvars; v++)
+        assigns[v] = l_Undef;
+    init_shuffle();
+
+    uint32_t qhead = 0, qtail = 0;
+    for (uint32_t i = 0; i < numclauses; i++) {
+        if (clsize[i] == 1)
+            init_enqueue(clause[i][0], qtail);
+    }
+
+    uint32_t next = 0;
+    while (true) {
+        if (qhead == qtail) {
+            while (next < numvars && assigns[init_order[next]] != l_Undef)
+                next++;
+            if (next == numvars)
+                break;
+            init_enqueue(Lit(init_order[next], rng.coin()), qtail);
+        }
+
+        const uint32_t v = init_queue[qhead++];
+        const Lit truelit(v, assigns[v] == l_False);
+        const uint32_t* occ = occurrence[truelit.toInt()];
+        for (uint32_t j = 0; j < numoccurrence[truelit.toInt()]; j++)
+            numtruelit[occ[j]]++;
+
+        occ = occurrence[(~truelit).toInt()];
+        for (uint32_t j = 0; j < numoccurrence[(~truelit).toInt()]; j++) {
+            const uint32_t cli = occ[j];
+            /* a false clause with one var left unset implies its literal */
+            if (++wherefalse[cli] != clsize[cli] - 1 || numtruelit[cli] > 0)
+                continue;
+            const Lit* lits = clause[cli];
+            uint32_t k = 0;
+            while (k < clsize[cli] && assigns[lits[k].var()] != l_Undef)
+                k++;
+            if (k < clsize[cli])
+                init_enqueue(lits[k], qtail);
+        }
+    }
+}
+
+/********************************************************************/
+/* Iterated local search, with -restart current or best: the tries  */
+/* after the first start from where the last one ended, or from the */
+/* best assignment of the run, and flip a random -perturb fraction  */
+/* of the vars.  All flips go through flipvar(), so the counters    */
+/* stay up to date and no O(literals) rebuild is needed.            */
+/********************************************************************/
+
+const char* WalkSAT::restart_mode_name(RestartMode mode)
+{
+    switch (mode) {
+        case RESTART_FULL: return "full";
+        case RESTART_CURRENT: return "current";
+        case RESTART_BEST: return "best";
+    }
+    return "?";
+}
+
+void WalkSAT::restart()
+{
+    if (trace != NULL)
+        trace_record(TRACE_RESTART, numtry);
+    uint32_t n = 0;
+    if (restart_mode == RESTART_BEST && best_numfalse <= numclauses) {
+        /* back to the best, kept up to date by save_best() at every try end */
+        for (uint32_t v = 0; v < numvars; v++) {
+            if (assigns[v] != best_assigns[v])
+                init_order[n++] = v;
+        }
+        restart_flips(init_order, n);
+        for (uint32_t i = 0; i < numvars; i++)
+            init_order[i] = i;
+    }
+
+    /* a random subset, from a partial shuffle of the permutation init_order[] */
+    const uint32_t k = std::max<uint32_t>(1, (uint32_t)(perturb * numvars));
+    for (uint32_t i = 0; i < k && i < numvars; i++)
+        std::swap(init_order[i], init_order[i + rng.below(numvars - i)]);
+    restart_flips(init_order, std::min(k, numvars));
+}
+
+/* With -trace one at a time, each recorded like a flip of the search */
+void WalkSAT::restart_flips(const uint32_t* vars, uint32_t n)
+{
+    if (trace == NULL) {
+        replay_flips(vars, n);
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        replay_flips(vars + i, 1);
+        trace_record(vars[i], numfalse);
+    }
+}
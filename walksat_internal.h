@@ -0,0 +1,115 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+#ifndef WALKSAT_INTERNAL_H
+#define WALKSAT_INTERNAL_H
+
+/* Platform flags, constants and small helpers shared by the solver's */
+/* translation units.  Not part of the WalkSAT interface.             */
+
+/********************************************************************/
+/* Following tests set exactly one of the following flags to 1:     */
+/*    BSD:   BSD Unix                                               */
+/*    OSX:   Apple OS X                                           */
+/*    LINUX: Linux Unix                                           */
+/*    WINDOWS: Windows and DOS. Linking requires -l Winmm.lib       */
+/*    POSIX: Other POSIX OS                                         */
+/* Platform dependent differences:                                  */
+/*    Clock ticks per second determined by sysconf(_SC_CLK_TCK)     */
+/*        for BSD, OSX, and LINUX                                   */
+/*    Clock ticks per second fixed at 1000 for Windows              */
+/*    Clock ticks per second fixed at 1 for POSIX                   */
+/********************************************************************/
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include "time_mem.h"
+
+#if __FreeBSD__ || __NetBSD__ || __OpenBSD__ || __bsdi__ || _SYSTYPE_BSD
+#define BSD 1
+#elif __APPLE__ && __MACH__
+#define OSX 1
+#elif __unix__ || __unix || unix || __gnu_linux__ || linux || __linux
+#define LINUX 1
+#elif _WIN64 || _WIN23 || _WIN16 || __MSDOS__ || MSDOS || _MSDOS || __DOS__
+#define NT 1
+#else
+#define POSIX 1
+#endif
+
+//printing
+#if BSD || OSX || LINUX
+#define BIGFORMAT "li"
+#elif WINDOWS
+#define BIGFORMAT "I64d"
+#endif
+
+/************************************/
+/* Constant parameters              */
+/************************************/
+
+#define BIG 1000000000     /* a number bigger that the possible number of violated clauses */
+#define MAXATTEMPT 10      /* max number of times to attempt to find a non-tabu variable to flip */
+#define denominator 100000 /* denominator used in fractions to represent probabilities */
+#define ONE_PERCENT 1000   /* ONE_PERCENT / denominator = 0.01 */
+#define POLL_INTERVAL 4096 /* flips between calls to poll() */
+
+/* Signal that asked the search to stop, 0 for none, see install_stop_handlers() */
+extern volatile sig_atomic_t stop_signal;
+
+/**************************************/
+/* Inline utility functions           */
+/**************************************/
+
+static inline int ABS(int x)
+{
+    return x < 0 ? -x : x;
+}
+
+static inline int MAX(int x, int y)
+{
+    return x > y ? x : y;
+}
+
+/* A number of flips, with an optional K or M suffix */
+static inline int64_t parse_flips(const char* text)
+{
+    char* end;
+    int64_t n = strtoll(text, &end, 10);
+    if (*end == 'K' || *end == 'k')
+        n *= 1000;
+    else if (*end == 'M' || *end == 'm')
+        n *= 1000000;
+    return n;
+}
+
+/* Monotonic wall clock in seconds, for time limits and fine timings */
+static inline double wallTime()
+{
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif //WALKSAT_INTERNAL_H
@@ -23,9 +23,9 @@ THE SOFTWARE.
 #include "walksat.h"
 using namespace CMSat;
 
-int main()
+int main(int argc, char** argv)
 {
     WalkSAT walk;
-    walk.main();
+    walk.main(argc, argv);
     return 0;
 }
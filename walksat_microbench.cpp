@@ -0,0 +1,307 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Microbenchmarks of the hot kernels, one number per kernel:       */
+/*   flipvar   replays a recorded flip sequence from a fixed state  */
+/*   pickbest  picks repeatedly over one fixed set of false clauses */
+/*   init      restarts a try (random assignment and all counters)  */
+/*   initprob  parses the formula from memory, reported in MB/s     */
+/* Each is repeated -reps times and reported as mean ns per op with */
+/* its standard deviation over the repetitions.                     */
+/*                                                                  */
+/* use: microbench [-reps N] [-flips N] [-kernel K] [-prefetch]     */
+/*                 [-vars N] [-ratio R] [-k K] [cnf-file]           */
+/* Without a file a random k-SAT formula is generated.              */
+/********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+namespace CMSat {
+
+class MicroBench
+{
+public:
+    int main(int argc, char** argv);
+
+private:
+    struct Result
+    {
+        double mean;
+        double stddev;
+        double min;
+    };
+
+    void parse(int argc, char** argv);
+    void generate();
+    void load_formula();
+    template<class F, class S> Result measure(uint64_t ops, F body, S setup);
+    void report(const char* name, uint64_t ops, const Result& r, const char* unit = "ns/op");
+
+    void bench_flipvar();
+    void bench_pickbest();
+    void bench_init();
+    void bench_initprob();
+
+    WalkSAT s;
+    std::string text;   /* the formula in DIMACS */
+    const char* file = NULL;
+    uint32_t reps = 20;
+    uint32_t flips = 100000;
+    uint32_t genvars = 10000;
+    double genratio = 4.2;
+    uint32_t genk = 3;
+};
+
+}
+
+static inline double now_ns()
+{
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MicroBench::parse(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        if (opt[0] == '-' && opt[1] == '-')
+            opt++;
+        const bool has_arg = i + 1 < argc;
+
+        if (strcmp(opt, "-reps") == 0 && has_arg) {
+            reps = std::max(2, atoi(argv[++i]));
+        } else if (strcmp(opt, "-flips") == 0 && has_arg) {
+            flips = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-vars") == 0 && has_arg) {
+            genvars = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-ratio") == 0 && has_arg) {
+            genratio = atof(argv[++i]);
+        } else if (strcmp(opt, "-k") == 0 && has_arg) {
+            genk = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(opt, "-prefetch") == 0) {
+            s.prefetch = true;
+        } else if (strcmp(opt, "-kernel") == 0 && has_arg) {
+            const char* name = argv[++i];
+            s.kernel = KERNEL_SCALAR;
+            while (s.kernel <= KERNEL_AUTO && strcmp(name, WalkSAT::kernel_name(s.kernel)) != 0)
+                s.kernel = (KernelType)(s.kernel + 1);
+            if (s.kernel > KERNEL_AUTO) {
+                fprintf(stderr, "Unknown kernel '%s'\n", name);
+                exit(-1);
+            }
+        } else if (opt[0] != '-' && file == NULL) {
+            file = argv[i];
+        } else {
+            fprintf(stderr, "use: %s [-reps N] [-flips N] [-kernel K] [-prefetch] "
+                            "[-vars N] [-ratio R] [-k K] [cnf-file]\n", argv[0]);
+            exit(-1);
+        }
+    }
+
+    if (s.kernel == KERNEL_AUTO) {
+        s.kernel = WalkSAT::detect_kernel();
+    } else if (!WalkSAT::kernel_supported(s.kernel)) {
+        fprintf(stderr, "Kernel %s is not supported on this CPU\n", WalkSAT::kernel_name(s.kernel));
+        exit(-1);
+    }
+}
+
+/* Random k-SAT with distinct vars per clause, seeded for repeatable numbers */
+void MicroBench::generate()
+{
+    Rng rng;
+    rng.seed(1, 0);
+    const uint32_t numclauses = (uint32_t)(genvars * genratio);
+    const uint32_t k = std::min(genk, genvars);
+    text = "p cnf " + std::to_string(genvars) + " " + std::to_string(numclauses) + "\n";
+    std::vector<uint32_t> vars;
+    for (uint32_t i = 0; i < numclauses; i++) {
+        vars.clear();
+        while (vars.size() < k) {
+            const uint32_t v = rng.below(genvars) + 1;
+            if (std::find(vars.begin(), vars.end(), v) == vars.end())
+                vars.push_back(v);
+        }
+        for (uint32_t v : vars) {
+            text += rng.coin() ? "-" : "";
+            text += std::to_string(v) + " ";
+        }
+        text += "0\n";
+    }
+}
+
+/* Parse text into s, as the solver would from a file, reusing its arena */
+void MicroBench::load_formula()
+{
+    s.cnfStream = fmemopen((void*)text.data(), text.size(), "r");
+    if (s.cnfStream == NULL) {
+        perror("fmemopen");
+        exit(-1);
+    }
+    if (!s.initprob())
+        exit(-1);
+    fclose(s.cnfStream);
+    s.cnfStream = NULL;
+}
+
+/* Runs body reps times, setup (untimed) before each; ns per op */
+template<class F, class S>
+MicroBench::Result MicroBench::measure(uint64_t ops, F body, S setup)
+{
+    std::vector<double> t;
+    for (uint32_t r = 0; r < reps; r++) {
+        setup();
+        const double start = now_ns();
+        body();
+        t.push_back((now_ns() - start) / ops);
+    }
+
+    Result res;
+    res.mean = 0;
+    for (double x : t)
+        res.mean += x;
+    res.mean /= t.size();
+    double var = 0;
+    for (double x : t)
+        var += (x - res.mean) * (x - res.mean);
+    res.stddev = sqrt(var / (t.size() - 1));
+    res.min = *std::min_element(t.begin(), t.end());
+    return res;
+}
+
+void MicroBench::report(const char* name, uint64_t ops, const Result& r, const char* unit)
+{
+    printf("%-12s %10" BIGFORMAT " %12.2f %10.2f %12.2f  %s\n", name, (int64_t)ops, r.mean,
+           r.stddev, r.min, unit);
+    fflush(stdout);
+}
+
+/* Record a real flip sequence, then replay it from the same start state */
+void MicroBench::bench_flipvar()
+{
+    s.init();
+    std::vector<lbool> start(s.assigns, s.assigns + s.numvars);
+    std::vector<uint32_t> seq;
+    for (uint32_t i = 0; i < flips && s.numfalse > 0; i++) {
+        seq.push_back(s.pickvar());
+        s.replay_flips(&seq.back(), 1);
+    }
+    if (seq.empty())
+        return;
+
+    const Result r = measure(seq.size(),
+        [&]() { s.replay_flips(seq.data(), seq.size()); },
+        [&]() {
+            memcpy(s.assigns, start.data(), sizeof(lbool) * s.numvars);
+            s.init_counters();
+        });
+    report("flipvar", seq.size(), r);
+}
+
+/* Picks over the false clauses of one random assignment, no flips */
+void MicroBench::bench_pickbest()
+{
+    s.init();
+    if (s.numfalse == 0)
+        return;
+    volatile uint32_t sink = 0;
+    const Result r = measure(flips, [&]() {
+        uint32_t x = 0;
+        for (uint32_t i = 0; i < flips; i++)
+            x += s.pickvar();
+        sink = x;
+    }, []() {});
+    (void)sink;
+    report("pickbest", flips, r);
+}
+
+void MicroBench::bench_init()
+{
+    const Result r = measure(1, [&]() { s.init(); }, []() {});
+    report("init", 1, r);
+}
+
+void MicroBench::bench_initprob()
+{
+    const Result r = measure(text.size(), [&]() { load_formula(); }, []() {});
+    /* ns per byte -> MB/s */
+    Result mbs;
+    mbs.mean = 1000.0 / r.mean;
+    mbs.stddev = mbs.mean * r.stddev / r.mean;
+    mbs.min = 1000.0 / r.min;  /* best time gives the highest rate */
+    report("initprob", text.size(), mbs, "MB/s (min column: best)");
+}
+
+int MicroBench::main(int argc, char** argv)
+{
+    parse(argc, argv);
+    s.quiet = true;
+
+    if (file != NULL) {
+        FILE* f = fopen(file, "rb");
+        if (f == NULL) {
+            fprintf(stderr, "Cannot open %s\n", file);
+            exit(-1);
+        }
+        char buf[1 << 16];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            text.append(buf, n);
+        fclose(f);
+    } else {
+        generate();
+    }
+
+    s.seed = 1;
+    s.rng.seed(s.seed, 0);
+    s.numerator = (int)(s.walk_probability * denominator);
+    load_formula();
+    s.alloc_walker();
+
+    printf("formula = %u vars, %u clauses, %u literals\n", s.numvars, s.numclauses, s.numliterals);
+    printf("kernel = %s%s, %u reps\n", WalkSAT::kernel_name(s.kernel),
+           s.prefetch ? ", prefetching flips" : "", reps);
+    printf("%-12s %10s %12s %10s %12s\n", "benchmark", "ops/rep", "mean", "stddev", "min");
+
+    bench_flipvar();
+    bench_pickbest();
+    bench_init();
+    bench_initprob();
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    MicroBench bench;
+    return bench.main(argc, argv);
+}
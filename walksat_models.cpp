@@ -0,0 +1,119 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Distinct solutions, with -distinct and -mindist D.               */
+/*                                                                  */
+/* -numsol then counts distinct models only.  A model is known by   */
+/* the Zobrist hash of assigns[]: the xor of a random 64-bit key    */
+/* per true var, kept up to date by flipvar() with one xor per flip */
+/* and recomputed by init_counters().  With -mindist the models are */
+/* also kept as bit vectors, and one closer than D vars to any      */
+/* earlier model is not counted.  Each new model is printed as soon */
+/* as it is found, as one "v lit ... 0" line, or to -modelfile.    */
+/********************************************************************/
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+#include "walksat_output.h"
+
+using namespace CMSat;
+
+namespace CMSat {
+
+struct ModelSet
+{
+    std::unordered_set<uint64_t> hashes;
+    std::vector<uint64_t> bits;   /* the models, numwords words each, with -mindist */
+    std::vector<uint64_t> current;
+    uint32_t numwords;
+};
+
+}
+
+void WalkSAT::models_open()
+{
+    if (!distinct)
+        return;
+    models = new ModelSet;
+    models->numwords = (numvars + 63) / 64;
+    models_found = 0;
+
+    /* keys from their own stream, so the search is that of the same -seed */
+    Rng keys;
+    keys.seed(seed, 0x5eed2b);
+    zobrist = walker_mem->alloc<uint64_t>(numvars, "model hash keys");
+    for (uint32_t v = 0; v < numvars; v++)
+        zobrist[v] = keys.bits64();
+}
+
+void WalkSAT::models_close()
+{
+    delete models;
+    models = NULL;
+}
+
+uint64_t WalkSAT::model_hash() const
+{
+    uint64_t h = 0;
+    for (uint32_t v = 0; v < numvars; v++) {
+        if (assigns[v] == l_True)
+            h ^= zobrist[v];
+    }
+    return h;
+}
+
+/* At a solution; counts and prints it if it is new */
+void WalkSAT::models_add()
+{
+    if (!models->hashes.insert(assign_hash).second)
+        return;
+
+    if (mindist > 0) {
+        const uint32_t n = models->numwords;
+        models->current.assign(n, 0);
+        for (uint32_t v = 0; v < numvars; v++) {
+            if (assigns[v] == l_True)
+                models->current[v / 64] |= 1ULL << (v % 64);
+        }
+        for (size_t m = 0; m < models->bits.size(); m += n) {
+            uint32_t dist = 0;
+            for (uint32_t w = 0; w < n && dist < (uint32_t)mindist; w++)
+                dist += __builtin_popcountll(models->bits[m + w] ^ models->current[w]);
+            if (dist < (uint32_t)mindist)
+                return;
+        }
+        models->bits.insert(models->bits.end(), models->current.begin(), models->current.end());
+    }
+
+    models_found++;
+    printf("model %i found in try %i after %" BIGFORMAT " flips\n", models_found, numtry, numflip);
+    OutputBuffer out(model_out != NULL ? model_out : stdout,
+                     std::min<size_t>(1 << 20, (size_t)numvars * 12 + 64));
+    write_model(out, model_format == MODEL_BITMAP ? MODEL_BITMAP : MODEL_PACKED, false);
+    if (!out.flush())
+        fprintf(stderr, "Error writing model %i\n", models_found);
+}
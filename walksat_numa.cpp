@@ -0,0 +1,313 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* NUMA placement of the clause database and thread pinning.        */
+/*                                                                  */
+/* The clause database (clause, clsize, occurrence, numoccurrence)  */
+/* is read-only during the search.  With -numa interleave it is     */
+/* copied once into pages spread over all nodes; with -numa         */
+/* replicate every node a -coop worker may run on gets its own      */
+/* copy, read by the workers of that node; a single walker or node  */
+/* keeps the one copy.  The per-walk arrays are allocated and first */
+/* written by the worker's own thread, so the kernel's first-touch  */
+/* policy puts them on the worker's node.                           */
+/* -pin binds thread t to a core, spreading threads over the nodes. */
+/*                                                                  */
+/* Uses the raw mbind syscall and sysfs, so no libnuma is needed;   */
+/* on other systems all of this is a no-op.                         */
+/********************************************************************/
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
+using namespace CMSat;
+
+#define MAX_NUMA_NODES 64 /* one word of node mask */
+
+namespace CMSat {
+
+/* One copy of the read-only clause database */
+struct FormulaReplica
+{
+    Lit **clause = NULL;
+    uint32_t *clsize = NULL;
+    uint32_t **occurrence = NULL;
+    uint32_t *numoccurrence = NULL;
+    Arena *mem = NULL;  /* owns the arrays, NULL for the copy read by initprob() */
+};
+
+struct NumaState
+{
+    std::vector<std::vector<int> > nodecpus; /* cpus of each node */
+    std::vector<int> cpuorder;  /* cpu of thread t is cpuorder[t % size], alternating nodes */
+    std::vector<int> cpunode;   /* node of each cpu */
+    std::vector<FormulaReplica> replicas; /* per node, only with -numa replicate */
+
+    ~NumaState()
+    {
+        for (FormulaReplica& r : replicas)
+            delete r.mem;
+    }
+};
+
+}
+
+const char* WalkSAT::numa_mode_name(NumaMode mode)
+{
+    switch (mode) {
+        case NUMA_OFF: return "off";
+        case NUMA_INTERLEAVE: return "interleave";
+        case NUMA_REPLICATE: return "replicate";
+    }
+    return "?";
+}
+
+/* Topology and formula replicas; the replicas' arenas go with it */
+void WalkSAT::numa_release()
+{
+    delete numa;
+    numa = NULL;
+}
+
+#ifdef __linux__
+
+/* Parse a sysfs cpu list such as "0-3,8-11" */
+static std::vector<int> parse_cpulist(const char* path)
+{
+    std::vector<int> cpus;
+    FILE* f = fopen(path, "r");
+    if (f == NULL)
+        return cpus;
+    int lo, hi;
+    while (fscanf(f, "%d", &lo) == 1) {
+        hi = lo;
+        int c = fgetc(f);
+        if (c == '-') {
+            if (fscanf(f, "%d", &hi) != 1)
+                break;
+            c = fgetc(f);
+        }
+        for (int cpu = lo; cpu <= hi; cpu++)
+            cpus.push_back(cpu);
+        if (c != ',')
+            break;
+    }
+    fclose(f);
+    return cpus;
+}
+
+/* Called before the formula is read: topology, and pinning of the main thread */
+void WalkSAT::numa_setup()
+{
+    if (numa_mode == NUMA_OFF && !pin)
+        return;
+
+    numa = new NumaState;
+    for (int node = 0; node < MAX_NUMA_NODES; node++) {
+        const std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+        std::vector<int> cpus = parse_cpulist(path.c_str());
+        if (cpus.empty() && access(path.c_str(), F_OK) != 0)
+            continue;
+        numa->nodecpus.resize(node + 1);
+        numa->nodecpus[node] = cpus;
+    }
+    if (numa->nodecpus.empty()) {
+        /* no sysfs node info: one node with all cpus */
+        numa->nodecpus.resize(1);
+        for (long cpu = 0; cpu < sysconf(_SC_NPROCESSORS_CONF); cpu++)
+            numa->nodecpus[0].push_back(cpu);
+    }
+
+    /* round robin over the nodes, so threads spread over all of them */
+    for (size_t k = 0; ; k++) {
+        bool any = false;
+        for (size_t node = 0; node < numa->nodecpus.size(); node++) {
+            if (k < numa->nodecpus[node].size()) {
+                const int cpu = numa->nodecpus[node][k];
+                numa->cpuorder.push_back(cpu);
+                if (cpu >= (int)numa->cpunode.size())
+                    numa->cpunode.resize(cpu + 1, 0);
+                numa->cpunode[cpu] = node;
+                any = true;
+            }
+        }
+        if (!any)
+            break;
+    }
+
+    uint32_t numnodes = 0;
+    for (const std::vector<int>& cpus : numa->nodecpus)
+        numnodes += !cpus.empty();
+    printf("numa nodes = %u, cpus = %u\n", numnodes, (uint32_t)numa->cpuorder.size());
+
+    numa_pin_thread(0);
+}
+
+/* Pin the calling thread if -pin was given; returns the node it runs on */
+int WalkSAT::numa_pin_thread(uint32_t thread)
+{
+    if (numa == NULL || numa->cpuorder.empty())
+        return 0;
+    if (pin) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(numa->cpuorder[thread % numa->cpuorder.size()], &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+            perror("sched_setaffinity");
+    }
+    const int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= (int)numa->cpunode.size())
+        return 0;
+    return numa->cpunode[cpu];
+}
+
+/* Copy the clause database into memory allocated with the given policy */
+static FormulaReplica copy_formula(const FormulaReplica& from, uint32_t numclauses,
+                                   uint32_t numvars, uint32_t numliterals, int mode,
+                                   uint64_t nodemask)
+{
+    FormulaReplica to;
+    to.mem = new Arena;
+    to.mem->set_policy(mode, nodemask);
+    to.mem->reserve((sizeof(Lit *) + sizeof(uint32_t)) * (size_t)numclauses
+                    + (sizeof(uint32_t *) + sizeof(uint32_t)) * 2 * (size_t)numvars
+                    + (sizeof(Lit) + sizeof(uint32_t)) * (size_t)numliterals + 6 * 64);
+
+    to.clause = to.mem->alloc<Lit *>(numclauses, "clause pointers");
+    to.clsize = to.mem->alloc<uint32_t>(numclauses, "clause sizes");
+    to.occurrence = to.mem->alloc<uint32_t *>(2 * (size_t)numvars, "occurrence pointers");
+    to.numoccurrence = to.mem->alloc<uint32_t>(2 * (size_t)numvars, "occurrence counts");
+    Lit* lits = to.mem->alloc<Lit>(numliterals, "clause literals");
+    uint32_t* occs = to.mem->alloc<uint32_t>(numliterals, "occurrence lists");
+
+    /* clause and occurrence lists are each stored contiguously, in order */
+    memcpy(lits, from.clause[0], sizeof(Lit) * numliterals);
+    memcpy(occs, from.occurrence[0], sizeof(uint32_t) * numliterals);
+    memcpy(to.clsize, from.clsize, sizeof(uint32_t) * numclauses);
+    memcpy(to.numoccurrence, from.numoccurrence, sizeof(uint32_t) * 2 * numvars);
+    for (uint32_t i = 0; i < numclauses; i++)
+        to.clause[i] = lits + (from.clause[i] - from.clause[0]);
+    for (uint32_t i = 0; i < 2 * numvars; i++)
+        to.occurrence[i] = occs + (from.occurrence[i] - from.occurrence[0]);
+    return to;
+}
+
+/* Called after initprob(), before any walker state is allocated */
+void WalkSAT::numa_place_formula()
+{
+    if (numa_mode == NUMA_OFF || numclauses == 0)
+        return;
+
+    FormulaReplica home;
+    home.clause = clause;
+    home.clsize = clsize;
+    home.occurrence = occurrence;
+    home.numoccurrence = numoccurrence;
+
+    uint64_t allnodes = 0;
+    for (size_t node = 0; node < numa->nodecpus.size(); node++) {
+        if (!numa->nodecpus[node].empty())
+            allnodes |= 1ULL << node;
+    }
+
+    if (numa_mode == NUMA_INTERLEAVE) {
+        FormulaReplica spread = copy_formula(home, numclauses, numvars, numliterals,
+                                             MPOL_INTERLEAVE, allnodes);
+        delete formula_mem;
+        formula_mem = spread.mem;
+        clause = spread.clause;
+        clsize = spread.clsize;
+        occurrence = spread.occurrence;
+        numoccurrence = spread.numoccurrence;
+        return;
+    }
+
+    /* replicate only onto the nodes walkers run on: all of them unless */
+    /* pinned, and none if that is a single node                         */
+    const int homenode = numa_pin_thread(0);
+    const int walkers = coop_requested ? numthreads : 1;
+    uint64_t walkernodes = 1ULL << homenode;
+    for (int t = 1; t < walkers; t++) {
+        walkernodes |= pin ? 1ULL << numa->cpunode[numa->cpuorder[t % numa->cpuorder.size()]]
+                           : allnodes;
+    }
+    if (__builtin_popcountll(walkernodes) < 2)
+        return;
+
+    /* the copy read so far stays with the main thread's node */
+    numa->replicas.resize(numa->nodecpus.size());
+    numa->replicas[homenode] = home;
+    for (size_t node = 0; node < numa->nodecpus.size(); node++) {
+        if ((int)node == homenode || !((walkernodes >> node) & 1))
+            continue;
+        numa->replicas[node] = copy_formula(home, numclauses, numvars, numliterals,
+                                            MPOL_BIND, 1ULL << node);
+    }
+}
+
+/* Make this walker read the clause database copy of its node */
+void WalkSAT::numa_attach_formula(int node)
+{
+    if (numa == NULL || node >= (int)numa->replicas.size() || numa->replicas[node].clause == NULL)
+        return;
+    const FormulaReplica& replica = numa->replicas[node];
+    clause = replica.clause;
+    clsize = replica.clsize;
+    occurrence = replica.occurrence;
+    numoccurrence = replica.numoccurrence;
+}
+
+#else
+
+void WalkSAT::numa_setup()
+{
+    if (numa_mode != NUMA_OFF || pin)
+        fprintf(stderr, "NUMA placement and pinning are only supported on Linux, ignored\n");
+}
+
+int WalkSAT::numa_pin_thread(uint32_t)
+{
+    return 0;
+}
+
+void WalkSAT::numa_place_formula()
+{
+}
+
+void WalkSAT::numa_attach_formula(int)
+{
+}
+
+#endif
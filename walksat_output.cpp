@@ -0,0 +1,136 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Writing models, see walksat_output.h for the buffer.             */
+/*                                                                  */
+/* -modelformat lines  one "v lit" line per var, the classic output */
+/*              packed "v lit lit ... 0" lines of at most 80 chars, */
+/*                     as SAT competitions expect                   */
+/*              bitmap numvars bits, var 8i+j+1 in bit j of byte i, */
+/*                     true is 1; needs -modelfile                  */
+/* -modelfile FILE sends the models there instead of stdout; with   */
+/* -distinct every new model is appended, a bitmap file then holds  */
+/* one record of (numvars+7)/8 bytes per model.                     */
+/********************************************************************/
+
+#include <algorithm>
+#include "walksat.h"
+#include "walksat_internal.h"
+#include "walksat_output.h"
+
+using namespace CMSat;
+
+#define MODEL_LINE 80  /* longest packed line, the competition limit */
+
+const char* WalkSAT::model_format_name(ModelFormat format)
+{
+    switch (format) {
+        case MODEL_LINES: return "lines";
+        case MODEL_PACKED: return "packed";
+        case MODEL_BITMAP: return "bitmap";
+    }
+    return "?";
+}
+
+/* The current assignment; unwrapped packed output is one line */
+void WalkSAT::write_model(OutputBuffer& out, ModelFormat format, bool wrap)
+{
+    if (format == MODEL_BITMAP) {
+        for (uint32_t v = 0; v < numvars; v += 8) {
+            const uint32_t n = std::min(8u, numvars - v);
+            uint32_t byte = 0;
+            for (uint32_t j = 0; j < n; j++)
+                byte |= (uint32_t)(assigns[v + j] == l_True) << j;
+            out.put((char)byte);
+        }
+        return;
+    }
+
+    if (format == MODEL_LINES) {
+        for (uint32_t v = 0; v < numvars; v++) {
+            out.put("v ");
+            out.put_int(assigns[v] == l_True ? (int64_t)v + 1 : -((int64_t)v + 1));
+            out.put('\n');
+        }
+        return;
+    }
+
+    size_t len = 1;
+    out.put('v');
+    for (uint32_t v = 0; v < numvars; v++) {
+        /* a literal is at most 11 chars, and room is left for " 0" */
+        if (wrap && len + 14 > MODEL_LINE) {
+            out.put("\nv");
+            len = 1;
+        }
+        out.put(' ');
+        len += 1 + out.put_int(assigns[v] == l_True ? (int64_t)v + 1 : -((int64_t)v + 1));
+    }
+    out.put(" 0\n");
+}
+
+/* The current assignment in -modelformat, to -modelfile or stdout */
+void WalkSAT::print_sol_cnf()
+{
+    OutputBuffer out(model_out != NULL ? model_out : stdout,
+                     std::min<size_t>(1 << 20, (size_t)numvars * 12 + 64));
+    write_model(out, model_format, true);
+    if (!out.flush())
+        fprintf(stderr, "Error writing the model to %s\n", model_path != NULL ? model_path : "stdout");
+    else if (model_out != NULL)
+        printf("model written to %s\n", model_path);
+}
+
+void WalkSAT::model_output_open()
+{
+    if (model_path == NULL)
+        return;
+    model_out = fopen(model_path, "wb");
+    if (model_out == NULL) {
+        fprintf(stderr, "Cannot open model file %s\n", model_path);
+        exit(-1);
+    }
+}
+
+void WalkSAT::model_output_close()
+{
+    if (model_out == NULL)
+        return;
+    if (fclose(model_out) != 0)
+        fprintf(stderr, "Error writing the model to %s\n", model_path);
+    model_out = NULL;
+}
+
+/* Per-try rows reach a pipe or file at most once a second, not  */
+/* in a write() per try.  Called at try ends and from poll(), so  */
+/* a row waits about a second at most; a terminal is line        */
+/* buffered anyway.                                               */
+void WalkSAT::flush_progress()
+{
+    const double now = wallTime();
+    if (now < next_flush)
+        return;
+    fflush(stdout);
+    next_flush = now + 1;
+}
@@ -0,0 +1,153 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+#ifndef WALKSAT_OUTPUT_H
+#define WALKSAT_OUTPUT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace CMSat {
+
+/********************************************************************/
+/* Buffered writer for bulk output such as models.                  */
+/*                                                                  */
+/* Text is assembled in a private buffer with hand-rolled integer   */
+/* formatting, two digits per table lookup, and handed to the FILE  */
+/* in large fwrite()s, so a model of millions of vars is written at */
+/* close to memory bandwidth instead of one printf() per var.       */
+/* Text reaches the FILE when the buffer fills, on flush() and in   */
+/* the destructor.  The FILE itself is never flushed, so printf()s  */
+/* to it before and after the writer stay in order.                 */
+/********************************************************************/
+
+class OutputBuffer
+{
+public:
+    explicit OutputBuffer(FILE* out, size_t size = 1 << 20) :
+        out(out), size(size < 64 ? 64 : size), used(0), ok(true)
+    {
+        buf = (char*)malloc(this->size);
+        if (buf == NULL) {
+            fprintf(stderr, "Out of memory allocating an output buffer\n");
+            exit(-1);
+        }
+    }
+
+    ~OutputBuffer()
+    {
+        flush();
+        free(buf);
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void put(char c)
+    {
+        if (used == size)
+            drain();
+        buf[used++] = c;
+    }
+
+    void put(const char* s)
+    {
+        write(s, strlen(s));
+    }
+
+    /* Returns the number of chars written */
+    size_t put_int(int64_t v)
+    {
+        if (size - used < 24)
+            drain();
+        char tmp[24];
+        char* end = tmp + sizeof(tmp);
+        char* p = end;
+        uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+        while (u >= 100) {
+            const char* d = digits() + 2 * (u % 100);
+            u /= 100;
+            *--p = d[1];
+            *--p = d[0];
+        }
+        if (u >= 10) {
+            const char* d = digits() + 2 * u;
+            *--p = d[1];
+            *--p = d[0];
+        } else {
+            *--p = (char)('0' + u);
+        }
+        if (v < 0)
+            *--p = '-';
+        memcpy(buf + used, p, end - p);
+        used += end - p;
+        return end - p;
+    }
+
+    void write(const void* data, size_t n)
+    {
+        if (n > size - used) {
+            drain();
+            if (n >= size) {
+                ok &= fwrite(data, 1, n, out) == n;
+                return;
+            }
+        }
+        memcpy(buf + used, data, n);
+        used += n;
+    }
+
+    /* false if anything failed to be written */
+    bool flush()
+    {
+        drain();
+        return ok;
+    }
+
+private:
+    void drain()
+    {
+        if (used > 0)
+            ok &= fwrite(buf, 1, used, out) == used;
+        used = 0;
+    }
+
+    static const char* digits()
+    {
+        return "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+               "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+               "8081828384858687888990919293949596979899";
+    }
+
+    FILE* out;
+    char* buf;
+    size_t size;
+    size_t used;
+    bool ok;
+};
+
+}
+
+#endif //WALKSAT_OUTPUT_H
@@ -0,0 +1,236 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Hardware performance counters of the search, with -perf.         */
+/*                                                                  */
+/* Cycles, instructions, last level cache misses, branch misses and */
+/* dTLB load misses of this process are read with perf_event_open   */
+/* around every try, user space only so that it works with the      */
+/* default perf_event_paranoid.  A counter the cpu or kernel does   */
+/* not offer reads "n/a".  When the kernel multiplexes counters the */
+/* counts are scaled by time enabled over time running.  Next to    */
+/* them are two software counters kept by flipvar(): occurrences    */
+/* visited and clauses rescanned for their true literal.            */
+/*                                                                  */
+/* With -coop only the main thread is counted; -colorflip, -batch  */
+/* and -daemon do not run the measured flip loop of a single walker */
+/* and reject -perf.                                                */
+/********************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#endif
+
+using namespace CMSat;
+
+namespace CMSat {
+
+enum PerfCounter { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_LLC_MISSES, PERF_BRANCH_MISSES,
+                   PERF_DTLB_MISSES, PERF_NUM };
+
+struct PerfState
+{
+    int fd[PERF_NUM];
+    double start[PERF_NUM];   /* counts at the start of the try */
+    double tries[PERF_NUM];   /* sum over finished tries */
+    uint64_t occ_start, rescans_start;
+    uint64_t occ_total = 0, rescans_total = 0;
+    int64_t flips_total = 0;
+    double last[PERF_NUM];    /* counts of the last try, for perf_print_try() */
+    uint64_t last_occ = 0, last_rescans = 0;
+    int64_t last_flips = 0;
+};
+
+}
+
+#ifdef __linux__
+
+static int perf_open_counter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* Count so far, scaled up if the counter was multiplexed; -1 if unavailable */
+static double perf_read_counter(int fd)
+{
+    uint64_t v[3];
+    if (fd < 0 || read(fd, v, sizeof(v)) != (ssize_t)sizeof(v) || v[2] == 0)
+        return -1;
+    return v[2] < v[1] ? (double)v[0] * v[1] / v[2] : (double)v[0];
+}
+
+void WalkSAT::perf_open()
+{
+    if (!perf)
+        return;
+    perfstate = new PerfState;
+    PerfState& p = *perfstate;
+    p.fd[PERF_CYCLES] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    p.fd[PERF_INSTRUCTIONS] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    p.fd[PERF_LLC_MISSES] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    p.fd[PERF_BRANCH_MISSES] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    p.fd[PERF_DTLB_MISSES] = perf_open_counter(PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+
+    int opened = 0;
+    for (int k = 0; k < PERF_NUM; k++) {
+        p.tries[k] = 0;
+        opened += p.fd[k] >= 0;
+    }
+    if (opened == 0)
+        fprintf(stderr, "perf_event_open failed (%s), hardware counters unavailable\n",
+                strerror(errno));
+}
+
+void WalkSAT::perf_close()
+{
+    if (perfstate == NULL)
+        return;
+    for (int k = 0; k < PERF_NUM; k++)
+        if (perfstate->fd[k] >= 0)
+            close(perfstate->fd[k]);
+    delete perfstate;
+    perfstate = NULL;
+}
+
+#else
+
+static double perf_read_counter(int)
+{
+    return -1;
+}
+
+void WalkSAT::perf_open()
+{
+    if (!perf)
+        return;
+    fprintf(stderr, "Hardware counters are only supported on Linux, only software counters kept\n");
+    perfstate = new PerfState;
+    for (int k = 0; k < PERF_NUM; k++) {
+        perfstate->fd[k] = -1;
+        perfstate->tries[k] = 0;
+    }
+}
+
+void WalkSAT::perf_close()
+{
+    delete perfstate;
+    perfstate = NULL;
+}
+
+#endif
+
+void WalkSAT::perf_try_start()
+{
+    if (perfstate == NULL)
+        return;
+    PerfState& p = *perfstate;
+    p.occ_start = occ_visited;
+    p.rescans_start = clause_rescans;
+    for (int k = 0; k < PERF_NUM; k++)
+        p.start[k] = perf_read_counter(p.fd[k]);
+}
+
+/* Prints "name value" per flip, or n/a for a counter that cannot be read */
+static void perf_print_rate(const char* name, double count, double flips)
+{
+    if (count < 0 || flips <= 0)
+        printf(" %s %s", name, "n/a");
+    else
+        printf(" %s %.2f", name, count / flips);
+}
+
+static void perf_print_counts(const double* c, double occ, double rescans, double flips)
+{
+    perf_print_rate("cycles/flip", c[PERF_CYCLES], flips);
+    perf_print_rate("instr/flip", c[PERF_INSTRUCTIONS], flips);
+    if (c[PERF_CYCLES] > 0 && c[PERF_INSTRUCTIONS] >= 0)
+        printf(" IPC %.2f", c[PERF_INSTRUCTIONS] / c[PERF_CYCLES]);
+    else
+        printf(" IPC n/a");
+    perf_print_rate("LLC-miss/flip", c[PERF_LLC_MISSES], flips);
+    perf_print_rate("br-miss/flip", c[PERF_BRANCH_MISSES], flips);
+    perf_print_rate("dTLB-miss/flip", c[PERF_DTLB_MISSES], flips);
+    perf_print_rate("occ/flip", occ, flips);
+    perf_print_rate("rescans/flip", rescans, flips);
+    printf("\n");
+}
+
+/* Adds this try to the run totals, also for a quiet walker */
+void WalkSAT::perf_try_end()
+{
+    if (perfstate == NULL)
+        return;
+    PerfState& p = *perfstate;
+    for (int k = 0; k < PERF_NUM; k++) {
+        const double now = perf_read_counter(p.fd[k]);
+        p.last[k] = now < 0 || p.start[k] < 0 ? -1 : now - p.start[k];
+        if (p.last[k] < 0)
+            p.tries[k] = -1;
+        else if (p.tries[k] >= 0)
+            p.tries[k] += p.last[k];
+    }
+    p.last_occ = occ_visited - p.occ_start;
+    p.last_rescans = clause_rescans - p.rescans_start;
+    p.last_flips = numflip;
+    p.occ_total += p.last_occ;
+    p.rescans_total += p.last_rescans;
+    p.flips_total += numflip;
+}
+
+/* The counts of the last try, under its row */
+void WalkSAT::perf_print_try()
+{
+    if (perfstate == NULL)
+        return;
+    const PerfState& p = *perfstate;
+    printf("    perf:");
+    perf_print_counts(p.last, p.last_occ, p.last_rescans, p.last_flips);
+}
+
+void WalkSAT::perf_print_final()
+{
+    if (perfstate == NULL)
+        return;
+    const PerfState& p = *perfstate;
+    printf("per flip over all tries (%" BIGFORMAT " flips):", p.flips_total);
+    perf_print_counts(p.tries, p.occ_total, p.rescans_total, p.flips_total);
+}
@@ -0,0 +1,170 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+#ifndef WALKSAT_RNG_H
+#define WALKSAT_RNG_H
+
+#include <cstdint>
+
+namespace CMSat {
+
+/********************************************************************/
+/* Random number streams.                                           */
+/*                                                                  */
+/* Every walker owns a RandomStream seeded from (seed, stream), so  */
+/* runs are reproducible per seed whatever the number of threads.   */
+/* The engine is a template parameter; Xoshiro256 is the default,   */
+/* build with -DWALKSAT_RNG_PCG for Pcg32.  below() is Lemire's     */
+/* multiply-shift bounded draw, with rejection so it is unbiased.   */
+/********************************************************************/
+
+/* Expands a seed into engine state, see Vigna's splitmix64 */
+static inline uint64_t splitmix64(uint64_t& x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* xoshiro256** by Blackman and Vigna */
+class Xoshiro256
+{
+public:
+    void seed(uint64_t seed, uint64_t stream)
+    {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (int i = 0; i < 4; i++)
+            s[i] = splitmix64(x);
+    }
+
+    uint64_t next64()
+    {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    uint32_t next32()
+    {
+        return (uint32_t)(next64() >> 32);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s[4];
+};
+
+/* PCG-XSH-RR 64/32 by O'Neill; the stream selects the increment */
+class Pcg32
+{
+public:
+    void seed(uint64_t seed, uint64_t stream)
+    {
+        uint64_t x = seed;
+        inc = (stream << 1) | 1;
+        state = 0;
+        next32();
+        state += splitmix64(x);
+        next32();
+    }
+
+    uint32_t next32()
+    {
+        const uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        const uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        const uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    uint64_t next64()
+    {
+        const uint64_t hi = next32();
+        return (hi << 32) | next32();
+    }
+
+private:
+    uint64_t state;
+    uint64_t inc;
+};
+
+template<class Engine>
+class RandomStream
+{
+public:
+    void seed(uint64_t seed, uint64_t stream)
+    {
+        engine.seed(seed, stream);
+    }
+
+    /* Uniform in [0, n); n <= 1 gives 0 without a draw, like RANDMOD() did */
+    uint32_t below(uint32_t n)
+    {
+        if (n <= 1)
+            return 0;
+        uint64_t m = (uint64_t)engine.next32() * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            const uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                m = (uint64_t)engine.next32() * n;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    bool coin()
+    {
+        return engine.next32() >> 31;
+    }
+
+    uint64_t bits64()
+    {
+        return engine.next64();
+    }
+
+private:
+    Engine engine;
+};
+
+#ifdef WALKSAT_RNG_PCG
+typedef RandomStream<Pcg32> Rng;
+#else
+typedef RandomStream<Xoshiro256> Rng;
+#endif
+
+}
+
+#endif //WALKSAT_RNG_H
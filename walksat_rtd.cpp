@@ -0,0 +1,182 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Run-length distribution of the tries.                            */
+/*                                                                  */
+/* Every try adds its flips to a histogram of HISTMAX log buckets,  */
+/* two per power of two, if it succeeded; otherwise it is counted   */
+/* as censored, i.e. it would have needed more flips.  Each bucket  */
+/* also keeps the longest measured wall time of its tries, so the   */
+/* table gives measured seconds to solution, not flips times the    */
+/* mean rate.  The memory is fixed whatever the number of tries.    */
+/* From the histogram:                                              */
+/*   - the expected flips per solution had the cutoff been the end  */
+/*     of each bucket, cutting every longer try there; the best     */
+/*     one is suggested as cutoff                                   */
+/*   - the tail index, minus the slope of log P(T > t) over log t   */
+/*     beyond the median run length.  Below 1 the run lengths have  */
+/*     no finite mean and restarts pay off; well above 1 the        */
+/*     cutoff matters little.                                       */
+/* Useful with many tries: -numsol N -tries M.                      */
+/********************************************************************/
+
+#include <cmath>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+/* 2k for [2^k, 1.5*2^k), 2k+1 for [1.5*2^k, 2^(k+1)) */
+int WalkSAT::hist_bucket(int64_t flips)
+{
+    if (flips < 2)
+        return 0;
+    const int k = 63 - __builtin_clzll((uint64_t)flips);
+    const int b = 2 * k + (int)((flips >> (k - 1)) & 1);
+    return std::min(b, HISTMAX - 1);
+}
+
+/* Largest run length in bucket b */
+int64_t WalkSAT::hist_bucket_end(int b)
+{
+    const int k = b / 2;
+    if (b % 2 == 1)
+        return (int64_t)((2ULL << k) - 1);
+    return k == 0 ? 1 : (int64_t)((1ULL << k) + (1ULL << (k - 1)) - 1);
+}
+
+void WalkSAT::hist_record()
+{
+    histtotal++;
+    if (numfalse == 0) {
+        const int b = hist_bucket(numflip);
+        histcount[b]++;
+        histflips[b] += numflip;
+        histsecs[b] = std::max(histsecs[b], wallTime() - try_start);
+    } else {
+        hist_censored++;
+        hist_censored_flips += numflip;
+    }
+}
+
+/* The bucket end that minimizes the expected flips per solution, */
+/* or the cutoff used if no shorter one does better                */
+bool WalkSAT::hist_suggest_cutoff(int64_t& best_cutoff, double& expected)
+{
+    int64_t solved = 0;
+    double solvedflips = 0;
+    for (int b = 0; b < HISTMAX; b++) {
+        solved += histcount[b];
+        solvedflips += histflips[b];
+    }
+    if (solved == 0)
+        return false;
+
+    /* as run: every try ran to its end */
+    best_cutoff = cutoff;
+    expected = (solvedflips + hist_censored_flips) / solved;
+
+    int64_t below = 0;
+    double belowflips = 0;
+    for (int b = 0; b < HISTMAX - 1; b++) {
+        below += histcount[b];
+        belowflips += histflips[b];
+        const int64_t t = hist_bucket_end(b);
+        if (below == 0 || t >= cutoff)
+            continue;
+        const double e = (belowflips + (double)t * (histtotal - below)) / below;
+        if (e < expected) {
+            expected = e;
+            best_cutoff = t;
+        }
+    }
+    return true;
+}
+
+bool WalkSAT::hist_tail_index(double& alpha)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int n = 0;
+    int64_t above = histtotal;
+    for (int b = 0; b < HISTMAX - 1; b++) {
+        above -= histcount[b];
+        const int64_t t = hist_bucket_end(b);
+        if (t >= cutoff || above == 0)
+            break;
+        const double survival = (double)above / histtotal;
+        if (survival > 0.5 || histcount[b] == 0)
+            continue;
+        const double lx = log((double)t), ly = log(survival);
+        sx += lx;
+        sy += ly;
+        sxx += lx * lx;
+        sxy += lx * ly;
+        n++;
+    }
+    if (n < 2 || n * sxx - sx * sx <= 0)
+        return false;
+    alpha = -(n * sxy - sx * sy) / (n * sxx - sx * sx);
+    return true;
+}
+
+void WalkSAT::print_run_lengths()
+{
+    printf("run-length distribution (%ld tries, %" BIGFORMAT " without solution)\n", histtotal,
+           hist_censored);
+    if (histtotal == 0)
+        return;
+    int first = HISTMAX, last = -1;
+    for (int b = 0; b < HISTMAX; b++) {
+        if (histcount[b] > 0) {
+            first = std::min(first, b);
+            last = b;
+        }
+    }
+    if (last >= 0) {
+        printf("     flips up to     tries  P(solved)  seconds up to\n");
+        int64_t cumulative = 0;
+        double secs = 0;
+        for (int b = first; b <= last; b++) {
+            cumulative += histcount[b];
+            secs = std::max(secs, histsecs[b]);
+            const int64_t t = b == HISTMAX - 1 ? cutoff : hist_bucket_end(b);
+            printf("  %14" BIGFORMAT " %9" BIGFORMAT " %10.4f %14.6f\n", t, histcount[b],
+                   (double)cumulative / histtotal, secs);
+        }
+    }
+
+    int64_t best_cutoff;
+    double expected;
+    if (hist_suggest_cutoff(best_cutoff, expected))
+        printf("suggested cutoff = %" BIGFORMAT ", expected flips per solution = %.0f"
+               " (about %f seconds at the mean flip rate)\n", best_cutoff, expected,
+               expected * seconds_per_flip);
+    else
+        printf("suggested cutoff = none, no try succeeded\n");
+    double alpha;
+    if (hist_tail_index(alpha))
+        printf("tail index = %.3f%s\n", alpha, alpha < 1 ? ", heavy tail: restarts pay off" : "");
+    else
+        printf("tail index = n/a, too few tries beyond the median\n");
+}
@@ -0,0 +1,318 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Machine readable statistics, with -stats DEST.                   */
+/*                                                                  */
+/* DEST is a file name, or a number for an already open file        */
+/* descriptor (e.g. -stats 3 with 3>stats.jsonl in the shell).      */
+/* With -batch there is one "instance" record per formula instead,  */
+/* written to standard output if no DEST is given.                  */
+/* Records are JSON objects, one per line, or with -statsformat csv */
+/* rows under one header line of all columns, unused ones empty:    */
+/*   try       at the end of every try                              */
+/*   progress  every -progress N flips (or N seconds with an s      */
+/*             suffix) during a try, checked when poll() runs       */
+/*   summary   once, with the final statistics                      */
+/* Times of try, progress and summary records are CPU seconds      */
+/* (cpu_seconds, in the summary of all -coop threads); those of     */
+/* instance records wall-clock seconds (parse_wall_seconds,         */
+/* wall_seconds), as the -batch workers share the process.          */
+/* Every record is flushed as written, so the stream can be tailed. */
+/********************************************************************/
+
+#include <cstring>
+#include <mutex>
+#include "walksat.h"
+#include "walksat_internal.h"
+#include "time_mem.h"
+
+using namespace CMSat;
+
+namespace CMSat {
+
+struct StatsStream
+{
+    FILE *out = NULL;
+    bool csv = false;
+    bool instances = false;      /* -batch: instance records only */
+    std::mutex lock;             /* batch workers share the stream */
+    int64_t progress_flips = 0;  /* 0: no progress records by flips */
+    double progress_secs = 0;    /* 0: no progress records by time */
+    int64_t next_flips;          /* numflip of the next progress record */
+    double next_secs;            /* cpuTime() of the next progress record */
+    int64_t last_flips;          /* flips and time at the previous record, for the rate */
+    double last_secs;
+};
+
+}
+
+/* One value of a record; absent ones print as null or an empty cell */
+struct StatsField
+{
+    const char* name;
+    double value;
+    bool integer;
+    bool present;
+    const char* text;  /* a string value instead of the number */
+};
+
+static StatsField stat_int(const char* name, int64_t value, bool present = true)
+{
+    return StatsField{name, (double)value, true, present, NULL};
+}
+
+static StatsField stat_real(const char* name, double value, bool present = true)
+{
+    return StatsField{name, value, false, present, NULL};
+}
+
+static StatsField stat_text(const char* name, const char* text)
+{
+    return StatsField{name, 0, false, true, text};
+}
+
+static const char* csv_columns[] = {
+    "record", "file", "status", "vars", "clauses", "parse_wall_seconds", "try", "flips", "total_flips", "cpu_seconds", "wall_seconds", "flips_per_sec", "numfalse", "lowbad",
+    "avg_unsat", "std_dev_unsat", "undo_fraction", "solutions", "success_rate",
+    "mean_flips_to_solution", "suggested_cutoff", "tail_index", "rss_mb", "peak_rss_mb"
+};
+static const int num_csv_columns = sizeof(csv_columns) / sizeof(csv_columns[0]);
+
+/* Quoted, with the quotes (and in JSON backslashes and control */
+/* characters) escaped                                          */
+static void stats_text(FILE* out, const char* text, bool csv)
+{
+    fputc('"', out);
+    for (const char* c = text; *c; c++) {
+        if (*c == '"')
+            fputs(csv ? "\"\"" : "\\\"", out);
+        else if (*c == '\\' && !csv)
+            fputs("\\\\", out);
+        else if ((unsigned char)*c < 0x20 && !csv)
+            fprintf(out, "\\u%04x", (unsigned char)*c);
+        else
+            fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static void stats_value(FILE* out, const StatsField& f, const char* absent, bool csv)
+{
+    if (!f.present)
+        fputs(absent, out);
+    else if (f.text != NULL)
+        stats_text(out, f.text, csv);
+    else if (f.integer)
+        fprintf(out, "%" BIGFORMAT, (int64_t)f.value);
+    else
+        fprintf(out, "%.9g", f.value);
+}
+
+static void stats_emit(StatsStream* s, const char* record, const StatsField* fields, int n)
+{
+    std::lock_guard<std::mutex> guard(s->lock);
+    if (s->csv) {
+        fputs(record, s->out);
+        for (int c = 1; c < num_csv_columns; c++) {
+            fputc(',', s->out);
+            for (int k = 0; k < n; k++)
+                if (strcmp(fields[k].name, csv_columns[c]) == 0)
+                    stats_value(s->out, fields[k], "", true);
+        }
+    } else {
+        fprintf(s->out, "{\"record\":\"%s\"", record);
+        for (int k = 0; k < n; k++) {
+            fprintf(s->out, ",\"%s\":", fields[k].name);
+            stats_value(s->out, fields[k], "null", false);
+        }
+        fputc('}', s->out);
+    }
+    fputc('\n', s->out);
+    fflush(s->out);
+}
+
+void WalkSAT::stats_open()
+{
+    if (stats_dest == NULL && batch_path == NULL)
+        return;  /* the daemon only logs with -stats */
+    FILE* out = stdout;
+    if (stats_dest != NULL) {
+        char* end;
+        const long fd = strtol(stats_dest, &end, 10);
+        out = *end == '\0' && end != stats_dest ? fdopen((int)fd, "w") : fopen(stats_dest, "w");
+        if (out == NULL) {
+            fprintf(stderr, "Cannot open statistics stream %s\n", stats_dest);
+            exit(-1);
+        }
+    }
+
+    stats = new StatsStream;
+    stats->out = out;
+    stats->csv = stats_csv;
+    stats->instances = batch_path != NULL || daemon_path != NULL;
+    if (progress_every > 0) {
+        if (progress_in_seconds)
+            stats->progress_secs = progress_every;
+        else
+            stats->progress_flips = (int64_t)progress_every;
+    }
+
+    if (stats->csv) {
+        for (int c = 0; c < num_csv_columns; c++)
+            fprintf(out, "%s%s", c ? "," : "", csv_columns[c]);
+        fputc('\n', out);
+        fflush(out);
+    }
+}
+
+void WalkSAT::stats_close()
+{
+    if (stats == NULL)
+        return;
+    if (stats->out == stdout)
+        fflush(stdout);
+    else
+        fclose(stats->out);
+    delete stats;
+    stats = NULL;
+}
+
+void WalkSAT::stats_try_start()
+{
+    if (stats == NULL || stats->instances)
+        return;
+    stats->last_flips = 0;
+    stats->last_secs = cpuTime();
+    stats->next_flips = stats->progress_flips;
+    stats->next_secs = stats->last_secs + stats->progress_secs;
+}
+
+/* From poll(), so at most once every POLL_INTERVAL flips */
+void WalkSAT::stats_progress()
+{
+    StatsStream* s = stats;
+    if (s->instances)
+        return;
+    const bool flips_due = s->progress_flips > 0 && numflip >= s->next_flips;
+    if (!flips_due && s->progress_secs == 0)
+        return;
+    const double now = cpuTime();
+    if (!flips_due && now < s->next_secs)
+        return;
+
+    double vm_usage;
+    const uint64_t rss = memUsedTotal(vm_usage);
+    peak_rss = std::max(peak_rss, std::max(rss, memUsedPeak()));
+    const double secs = now - s->last_secs;
+    const StatsField f[] = {
+        stat_int("try", numtry),
+        stat_int("flips", numflip),
+        stat_int("total_flips", totalflip + numflip),
+        stat_real("cpu_seconds", now),
+        stat_real("flips_per_sec", secs > 0 ? (numflip - s->last_flips) / secs : 0, secs > 0),
+        stat_int("numfalse", numfalse),
+        stat_int("lowbad", lowbad, !lean),
+        stat_real("rss_mb", rss / 1048576.0),
+    };
+    stats_emit(s, "progress", f, sizeof(f) / sizeof(f[0]));
+
+    s->last_flips = numflip;
+    s->last_secs = now;
+    while (s->progress_flips > 0 && s->next_flips <= numflip)
+        s->next_flips += s->progress_flips;
+    while (s->progress_secs > 0 && s->next_secs <= now)
+        s->next_secs += s->progress_secs;
+}
+
+void WalkSAT::stats_try_end()
+{
+    if (stats == NULL || stats->instances)
+        return;
+    const bool sampled = !lean && sample_size > 0;
+    const StatsField f[] = {
+        stat_int("try", numtry),
+        stat_int("flips", numflip),
+        stat_int("total_flips", totalflip),
+        stat_real("cpu_seconds", cpuTime()),
+        stat_int("numfalse", numfalse),
+        stat_int("lowbad", lowbad, !lean),
+        stat_real("avg_unsat", avgfalse, sampled),
+        stat_real("std_dev_unsat", std_dev_avgfalse, sampled),
+        stat_real("undo_fraction", undo_fraction, !lean),
+        stat_int("solutions", found_solution),
+    };
+    stats_emit(stats, "try", f, sizeof(f) / sizeof(f[0]));
+}
+
+void WalkSAT::stats_final()
+{
+    if (stats == NULL || stats->instances)
+        return;
+    sample_memory();
+    int64_t best_cutoff = 0;
+    double expected, alpha = 0;
+    const bool suggested = hist_suggest_cutoff(best_cutoff, expected);
+    const bool fitted = hist_tail_index(alpha);
+    const StatsField f[] = {
+        stat_int("try", numtry),
+        stat_int("total_flips", totalflip),
+        stat_real("cpu_seconds", expertime),
+        stat_real("flips_per_sec", expertime > 0 ? totalflip / expertime : 0, expertime > 0),
+        stat_int("solutions", found_solution),
+        stat_real("success_rate", numtry ? found_solution * 100.0 / numtry : 0),
+        stat_real("mean_flips_to_solution", mean_x, found_solution),
+        stat_int("suggested_cutoff", best_cutoff, suggested),
+        stat_real("tail_index", alpha, fitted),
+        stat_real("peak_rss_mb", peak_rss / 1048576.0),
+    };
+    stats_emit(stats, "summary", f, sizeof(f) / sizeof(f[0]));
+}
+
+/* One formula of -batch or -daemon; status is sat, unknown or error. */
+/* Goes to out instead of the stream if given, as a daemon reply.     */
+void WalkSAT::stats_instance(const char* file, const char* status, double parse_seconds, FILE* out)
+{
+    const bool loaded = strcmp(status, "error") != 0;
+    const StatsField f[] = {
+        stat_text("file", file),
+        stat_text("status", status),
+        stat_int("vars", numvars, loaded),
+        stat_int("clauses", numclauses, loaded),
+        stat_real("parse_wall_seconds", parse_seconds, loaded),
+        stat_int("try", numtry, loaded),
+        stat_int("total_flips", totalflip, loaded),
+        stat_real("wall_seconds", expertime, loaded),
+        stat_real("flips_per_sec", expertime > 0 ? totalflip / expertime : 0,
+                  loaded && expertime > 0),
+        stat_int("solutions", found_solution, loaded),
+        stat_real("mean_flips_to_solution", mean_x, loaded && found_solution),
+    };
+    if (out != NULL) {
+        StatsStream reply;
+        reply.out = out;
+        stats_emit(&reply, "instance", f, sizeof(f) / sizeof(f[0]));
+    } else if (stats != NULL) {
+        stats_emit(stats, "instance", f, sizeof(f) / sizeof(f[0]));
+    }
+}
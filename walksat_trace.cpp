@@ -0,0 +1,180 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Flip trace, with -trace FILE.                                    */
+/*                                                                  */
+/* The flip loop stores one record of two 32-bit words per flip,    */
+/* (var, numfalse after the flip), in a ring buffer; every          */
+/* TRACE_CHUNK records it hands the filled part to a writer thread, */
+/* which appends it to FILE.  A try starts with three records:      */
+/*   (TRACE_TRY, try number), (flips before, low and high word),    */
+/*   (numfalse at the start, 0)                                     */
+/* so the flip number of every record is implied.  With -restart    */
+/* current or best the try header is preceded by the restart flips, */
+/* as (TRACE_RESTART, try number) and one (var, numfalse) record    */
+/* per flip, so the trajectory continues from the previous try.     */
+/* The file starts with a TraceHeader.  tracecsv turns it into     */
+/* CSV.  The loop waits for the writer only if the disk falls a     */
+/* whole ring behind.                                               */
+/* Only the main thread is traced.  Building with                   */
+/* -DWALKSAT_NO_TRACE removes the traced flip loops altogether.     */
+/********************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+#ifndef WALKSAT_NO_TRACE
+
+#define TRACE_RING (1 << 22)   /* records in the ring, 32 MB */
+#define TRACE_VERSION 2
+static const char TRACE_MAGIC[8] = {'\x7f', 'W', 'S', 'T', 'R', 'A', 'C', 'E'};
+
+/* Also declared by tracecsv.c */
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numvars;
+    uint32_t numclauses;
+    uint32_t seed;
+};
+
+namespace CMSat {
+
+struct TraceState
+{
+    FILE* out;
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable wake;      /* data for the writer, or room for the loop */
+    std::atomic<uint64_t> head{0};     /* records handed to the writer */
+    std::atomic<uint64_t> tail{0};     /* records written */
+    bool done = false;
+    bool failed = false;
+};
+
+}
+
+static void trace_writer(TraceState* t, const uint32_t* ring)
+{
+    std::unique_lock<std::mutex> guard(t->lock);
+    while (true) {
+        t->wake.wait(guard, [t]() { return t->done || t->head.load() > t->tail.load(); });
+        const uint64_t head = t->head.load(std::memory_order_acquire);
+        uint64_t tail = t->tail.load();
+        if (head == tail && t->done)
+            break;
+        guard.unlock();
+        while (tail < head) {
+            const uint64_t at = tail % TRACE_RING;
+            const uint64_t n = std::min<uint64_t>(head - tail, TRACE_RING - at);
+            if (fwrite(ring + 2 * at, 2 * sizeof(uint32_t), n, t->out) != n)
+                t->failed = true;
+            tail += n;
+        }
+        guard.lock();
+        t->tail.store(tail, std::memory_order_release);
+        t->wake.notify_all();
+    }
+}
+
+void WalkSAT::trace_open()
+{
+    if (trace_path == NULL)
+        return;
+    FILE* out = fopen(trace_path, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Cannot open trace file %s\n", trace_path);
+        exit(-1);
+    }
+    TraceHeader h;
+    memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+    h.version = TRACE_VERSION;
+    h.numvars = numvars;
+    h.numclauses = numclauses;
+    h.seed = seed;
+    fwrite(&h, sizeof(h), 1, out);
+
+    trace = new TraceState;
+    trace->out = out;
+    trace_ring = new uint32_t[2 * (size_t)TRACE_RING];
+    trace_mask = TRACE_RING - 1;
+    trace_pos = 0;
+    trace->writer = std::thread(trace_writer, trace, trace_ring);
+}
+
+/* Hands the records so far to the writer; waits until the next chunk has room */
+void WalkSAT::trace_publish()
+{
+    std::unique_lock<std::mutex> guard(trace->lock);
+    trace->head.store(trace_pos, std::memory_order_release);
+    trace->wake.notify_all();
+    trace->wake.wait(guard, [this]() {
+        return trace_pos + TRACE_CHUNK - trace->tail.load(std::memory_order_acquire) <= TRACE_RING;
+    });
+}
+
+void WalkSAT::trace_try_start()
+{
+    trace_record(TRACE_TRY, numtry);
+    trace_record((uint32_t)numflip, (uint32_t)((uint64_t)numflip >> 32));
+    trace_record(numfalse, 0);
+}
+
+void WalkSAT::trace_close()
+{
+    if (trace == NULL)
+        return;
+    {
+        std::lock_guard<std::mutex> guard(trace->lock);
+        trace->head.store(trace_pos, std::memory_order_release);
+        trace->done = true;
+        trace->wake.notify_all();
+    }
+    trace->writer.join();
+    if (fclose(trace->out) != 0 || trace->failed)
+        fprintf(stderr, "Error writing trace file %s\n", trace_path);
+    else if (!quiet)
+        printf("trace of %" BIGFORMAT " records written to %s\n", (int64_t)trace_pos, trace_path);
+    delete[] trace_ring;
+    delete trace;
+    trace = NULL;
+    trace_ring = NULL;
+}
+
+#else
+
+void WalkSAT::trace_open() {}
+void WalkSAT::trace_close() {}
+void WalkSAT::trace_try_start() {}
+void WalkSAT::trace_publish() {}
+
+#endif //WALKSAT_NO_TRACE
@@ -0,0 +1,186 @@
+/******************************************
+Copyright (c) 2018, Henry Kautz <henry.kautz@gmail.com>
+Copyright (c) 2018, Mate Soos <soos.mate@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+***********************************************/
+
+/********************************************************************/
+/* Parameter tuning with -tune, before the search.                  */
+/*                                                                  */
+/* Successive halving over a grid of walk probabilities, cutoffs    */
+/* (the -cutoff value times 0.1, 1 and 10) and restart modes: every */
+/* configuration left runs short probes on the loaded formula for   */
+/* a budget of flips, the better half survives, and the budget is   */
+/* doubled, until one is left.  A probe is a series of independent  */
+/* runs that each stop at their first solution, so its score is the */
+/* flips per solution; without solutions the fewest false clauses   */
+/* reached decides.  A probe also ends after TUNE_SOLUTIONS runs    */
+/* solved, as on easy formulas restarts would dominate its time.    */
+/* All configurations of a round draw from the same random stream,  */
+/* so those whose cutoffs both exceed the budget would run the same */
+/* probe; only the longest cutoff of them stays in the round.  The  */
+/* winner is printed as options for reuse, and the search then runs */
+/* with it exactly as if they were given.                           */
+/********************************************************************/
+
+#include <algorithm>
+#include <vector>
+#include "walksat.h"
+#include "walksat_internal.h"
+
+using namespace CMSat;
+
+#define TUNE_SOLUTIONS 20  /* a probe with this many solutions has used enough flips */
+
+namespace CMSat {
+
+struct TuneConfig
+{
+    double walk_probability;
+    int64_t cutoff;
+    RestartMode restart;
+    int64_t flips;      /* spent in the last round */
+    int64_t solved;
+    uint32_t lowbad;    /* fewest false clauses in the last round */
+};
+
+}
+
+/* Solving beats not solving, then fewer flips per solution or fewer false clauses */
+static bool tune_better(const TuneConfig& a, const TuneConfig& b)
+{
+    if ((a.solved > 0) != (b.solved > 0))
+        return a.solved > 0;
+    if (a.solved > 0)
+        return (double)a.flips / a.solved < (double)b.flips / b.solved;
+    return a.lowbad < b.lowbad;
+}
+
+/* Drops the configurations that would run the same probe as another */
+/* within budget flips, keeping the one with the longest cutoff       */
+static void tune_dedup(std::vector<TuneConfig>& configs, int64_t budget)
+{
+    std::vector<TuneConfig> kept;
+    for (const TuneConfig& c : configs) {
+        bool dup = false;
+        for (TuneConfig& k : kept) {
+            if (k.walk_probability == c.walk_probability && k.restart == c.restart
+                && std::min(k.cutoff, budget) == std::min(c.cutoff, budget)) {
+                if (c.cutoff > k.cutoff)
+                    k = c;
+                dup = true;
+                break;
+            }
+        }
+        if (!dup)
+            kept.push_back(c);
+    }
+    configs.swap(kept);
+}
+
+/* Runs c for about budget flips */
+void WalkSAT::tune_probe(TuneConfig& c, int64_t budget)
+{
+    walk_probability = c.walk_probability;
+    numerator = (int)(walk_probability * denominator);
+    restart_mode = c.restart;
+    cutoff = std::min(c.cutoff, budget);
+    numsol = 1;
+    alloc_walker();
+
+    c.flips = 0;
+    c.solved = 0;
+    c.lowbad = numclauses;
+    while (c.flips < budget && c.solved < TUNE_SOLUTIONS && !stopped) {
+        initialize_statistics();
+        numrun = (int)std::min<int64_t>((budget - c.flips + cutoff - 1) / cutoff, 1 << 30);
+        run_tries();
+        c.flips += totalflip;
+        c.solved += found_solution;
+        c.lowbad = std::min(c.lowbad, best_numfalse);
+    }
+}
+
+void WalkSAT::tune_parameters()
+{
+    const int saved_numrun = numrun;
+    const int saved_numsol = numsol;
+    const bool saved_quiet = quiet;
+    const bool saved_shared = shared_clauses;
+    quiet = true;
+    shared_clauses = true;  /* flipvar() must not reorder the literals of the search */
+
+    static const double probs[] = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6};
+    static const double cutoff_factors[] = {0.1, 1, 10};
+    static const RestartMode restarts[] = {RESTART_FULL, RESTART_BEST};
+    std::vector<TuneConfig> configs;
+    for (double p : probs) {
+        for (double f : cutoff_factors) {
+            for (RestartMode m : restarts) {
+                TuneConfig c;
+                c.walk_probability = p;
+                c.cutoff = std::max<int64_t>(1000, (int64_t)(f * base_cutoff));
+                c.restart = m;
+                configs.push_back(c);
+            }
+        }
+    }
+
+    printf("tuning %zu configurations, %" BIGFORMAT " flips each in the first round\n",
+           configs.size(), tune_flips);
+    const double start = wallTime();
+    int64_t budget = tune_flips;
+    for (int round = 1; configs.size() > 1 && !stopped; round++, budget *= 2) {
+        tune_dedup(configs, budget);
+        for (TuneConfig& c : configs) {
+            rng.seed(seed, 1000 + round);
+            tune_probe(c, budget);
+        }
+        std::stable_sort(configs.begin(), configs.end(), tune_better);
+        configs.resize((configs.size() + 1) / 2);
+
+        const TuneConfig& b = configs[0];
+        printf("round %i: %" BIGFORMAT " flips each, best -walkprob %.2f -cutoff %" BIGFORMAT
+               " -restart %s: ", round, budget, b.walk_probability, b.cutoff,
+               restart_mode_name(b.restart));
+        if (b.solved > 0)
+            printf("%" BIGFORMAT " flips per solution\n", b.flips / b.solved);
+        else
+            printf("lowbad %u\n", b.lowbad);
+        fflush(stdout);
+    }
+
+    const TuneConfig& best = configs[0];
+    walk_probability = best.walk_probability;
+    numerator = (int)(walk_probability * denominator);
+    cutoff = base_cutoff = best.cutoff;
+    restart_mode = best.restart;
+    numrun = saved_numrun;
+    numsol = saved_numsol;
+    quiet = saved_quiet;
+    shared_clauses = saved_shared;
+    printf("tuning took %.2f seconds\n", wallTime() - start);
+    printf("tuned parameters = -walkprob %.2f -cutoff %" BIGFORMAT " -restart %s\n\n",
+           walk_probability, cutoff, restart_mode_name(restart_mode));
+
+    /* the search itself starts as a run with these options would */
+    alloc_walker();
+    rng.seed(seed, worker_id);
+}